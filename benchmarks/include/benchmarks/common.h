@@ -0,0 +1,282 @@
+#pragma once
+
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "lib/midi/transport/ble/ble.h"
+#include "lib/midi/transport/serial/serial.h"
+#include "lib/midi/transport/serial/buffered.h"
+#include "lib/midi/transport/usb/usb.h"
+
+namespace benchmarks
+{
+    /// Stores packets written by the library while recording and replays them on read.
+    template<typename PacketT>
+    class Recorder
+    {
+        public:
+        void record(bool state)
+        {
+            _record = state;
+        }
+
+        void rewind()
+        {
+            _readIndex = 0;
+        }
+
+        protected:
+        bool push(PacketT& packet)
+        {
+            if (_record)
+            {
+                _packets.push_back(packet);
+            }
+
+            return true;
+        }
+
+        bool pop(PacketT& packet)
+        {
+            if (_readIndex == _packets.size())
+            {
+                return false;
+            }
+
+            packet = _packets[_readIndex++];
+            return true;
+        }
+
+        private:
+        std::vector<PacketT> _packets   = {};
+        size_t               _readIndex = 0;
+        bool                 _record    = false;
+    };
+
+    class SerialHwa : public lib::midi::serial::Hwa, public Recorder<lib::midi::serial::Packet>
+    {
+        public:
+        bool init() override
+        {
+            return true;
+        }
+
+        bool deInit() override
+        {
+            return true;
+        }
+
+        bool write(lib::midi::serial::Packet& packet) override
+        {
+            return push(packet);
+        }
+
+        bool read(lib::midi::serial::Packet& packet) override
+        {
+            return pop(packet);
+        }
+    };
+
+    /// Ring buffers are filled and drained by the benchmark itself, in place of interrupt routine.
+    class SerialRingHwa : public lib::midi::serial::BufferedHwa
+    {
+        public:
+        bool init() override
+        {
+            return true;
+        }
+
+        bool deInit() override
+        {
+            return true;
+        }
+
+        protected:
+        void startTransmission() override
+        {}
+    };
+
+    class UsbHwa : public lib::midi::usb::Hwa, public Recorder<lib::midi::usb::Packet>
+    {
+        public:
+        bool init() override
+        {
+            return true;
+        }
+
+        bool deInit() override
+        {
+            return true;
+        }
+
+        bool write(lib::midi::usb::Packet& packet) override
+        {
+            return push(packet);
+        }
+
+        bool read(lib::midi::usb::Packet& packet) override
+        {
+            return pop(packet);
+        }
+    };
+
+    class BleHwa : public lib::midi::ble::Hwa, public Recorder<lib::midi::ble::Packet>
+    {
+        public:
+        bool init() override
+        {
+            return true;
+        }
+
+        bool deInit() override
+        {
+            return true;
+        }
+
+        bool write(lib::midi::ble::Packet& packet) override
+        {
+            return push(packet);
+        }
+
+        bool read(lib::midi::ble::Packet& packet) override
+        {
+            return pop(packet);
+        }
+
+        uint32_t time() override
+        {
+            return 0;
+        }
+    };
+
+    struct SerialStack
+    {
+        using Hwa       = SerialHwa;
+        using Midi      = lib::midi::serial::Serial;
+        using Transport = lib::midi::serial::Transport;
+    };
+
+    struct UsbStack
+    {
+        using Hwa       = UsbHwa;
+        using Midi      = lib::midi::usb::Usb;
+        using Transport = lib::midi::usb::Transport;
+    };
+
+    struct BleStack
+    {
+        using Hwa       = BleHwa;
+        using Midi      = lib::midi::ble::Ble;
+        using Transport = lib::midi::ble::Transport;
+    };
+
+    /// MIDI instance together with its mock hardware.
+    template<typename Stack>
+    class Instance
+    {
+        public:
+        Instance()
+        {
+            _midi.init();
+        }
+
+        typename Stack::Hwa  _hwa;
+        typename Stack::Midi _midi = typename Stack::Midi(_hwa);
+    };
+
+    enum class scenario_t : uint8_t
+    {
+        DENSE_NOTES,          ///< Note On/Off messages on changing channels.
+        RUNNING_STATUS,       ///< Control Change sweep on a single channel, sent with running status.
+        INTERLEAVED_CLOCK,    ///< Notes with Timing Clock between them.
+        LARGE_SYS_EX,         ///< Single 4 kB SysEx message.
+    };
+
+    /// Sends messages of the specified scenario through the provided instance.
+    /// Returns false if any of the messages couldn't be sent.
+    template<typename Midi>
+    bool generate(Midi& midi, scenario_t scenario)
+    {
+        bool result = true;
+
+        switch (scenario)
+        {
+        case scenario_t::DENSE_NOTES:
+        {
+            for (size_t i = 0; i < 512; i++)
+            {
+                result &= midi.sendNoteOn(i & 0x7F, 127, (i % 16) + 1);
+                result &= midi.sendNoteOff(i & 0x7F, 0, (i % 16) + 1);
+            }
+        }
+        break;
+
+        case scenario_t::RUNNING_STATUS:
+        {
+            midi.setRunningStatusState(true);
+
+            for (size_t i = 0; i < 1024; i++)
+            {
+                result &= midi.sendControlChange(7, i & 0x7F, 1);
+            }
+
+            midi.setRunningStatusState(false);
+        }
+        break;
+
+        case scenario_t::INTERLEAVED_CLOCK:
+        {
+            for (size_t i = 0; i < 512; i++)
+            {
+                result &= midi.sendNoteOn(i & 0x7F, 127, 1);
+                result &= midi.sendRealTime(lib::midi::messageType_t::SYS_REAL_TIME_CLOCK);
+            }
+        }
+        break;
+
+        case scenario_t::LARGE_SYS_EX:
+        {
+            std::vector<uint8_t> sysEx(4096);
+
+            for (size_t i = 0; i < sysEx.size(); i++)
+            {
+                sysEx[i] = i & 0x7F;
+            }
+
+            result &= midi.sendSysEx(sysEx.size(), sysEx.data(), false);
+        }
+        break;
+
+        default:
+            break;
+        }
+
+        return result;
+    }
+
+    /// Raw MIDI stream of the specified scenario, as sent over serial.
+    inline std::vector<uint8_t> rawStream(scenario_t scenario)
+    {
+        Instance<SerialStack> instance;
+        std::vector<uint8_t>  stream;
+
+        instance._hwa.record(true);
+        generate(instance._midi, scenario);
+
+        lib::midi::serial::Packet packet;
+
+        while (instance._hwa.read(packet))
+        {
+            stream.push_back(packet.data);
+        }
+
+        return stream;
+    }
+
+    /// Reports amount of processed messages and bytes per second, together with time spent per byte.
+    inline void setCounters(benchmark::State& state, size_t messages, size_t bytes)
+    {
+        state.SetBytesProcessed(bytes);
+        state.counters["msg/s"]  = benchmark::Counter(messages, benchmark::Counter::kIsRate);
+        state.counters["s/byte"] = benchmark::Counter(bytes, benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+    }
+}    // namespace benchmarks
@@ -0,0 +1,139 @@
+#include "benchmarks/common.h"
+
+using namespace benchmarks;
+using namespace lib::midi;
+
+namespace
+{
+    /// Counts complete SysEx messages received in streaming mode.
+    class SysExCounter : public SysExStream
+    {
+        public:
+        void sysExChunk(sysExChunk_t type, const uint8_t*, size_t) override
+        {
+            if ((type == sysExChunk_t::END) || (type == sysExChunk_t::COMPLETE))
+            {
+                _count++;
+            }
+        }
+
+        size_t _count = 0;
+    };
+
+    class MessageCounter : public Sink
+    {
+        public:
+        void process(const Message&) override
+        {
+            _count++;
+        }
+
+        size_t _count = 0;
+    };
+
+    template<typename Stack>
+    void BM_Parse(benchmark::State& state)
+    {
+        const auto SCENARIO = static_cast<scenario_t>(state.range(0));
+
+        Instance<Stack> instance;
+        SysExCounter    sysExCounter;
+        size_t          messages = 0;
+
+        instance._hwa.record(true);
+
+        if (!generate(instance._midi, SCENARIO))
+        {
+            state.SkipWithError("scenario not supported by transport");
+            return;
+        }
+
+        instance._hwa.record(false);
+
+        // larger than MIDI_SYSEX_ARRAY_SIZE, stream it
+        instance._midi.setSysExStream(&sysExCounter);
+
+        for (auto _ : state)
+        {
+            instance._hwa.rewind();
+
+            while (instance._midi.read())
+            {
+                messages++;
+            }
+        }
+
+        setCounters(state, messages + sysExCounter._count, rawStream(SCENARIO).size() * state.iterations());
+    }
+
+    void BM_ParseSpan(benchmark::State& state)
+    {
+        const auto SCENARIO = static_cast<scenario_t>(state.range(0));
+        const auto STREAM   = rawStream(SCENARIO);
+
+        Instance<SerialStack> instance;
+        SysExCounter          sysExCounter;
+        MessageCounter        messageCounter;
+
+        instance._midi.setSysExStream(&sysExCounter);
+
+        for (auto _ : state)
+        {
+            instance._midi.parse(STREAM.data(), STREAM.size(), messageCounter);
+        }
+
+        setCounters(state, messageCounter._count + sysExCounter._count, STREAM.size() * state.iterations());
+    }
+
+    /// Parses the stream received into ring buffer of BufferedHwa, filled
+    /// in blocks in the same way as done by DMA.
+    void BM_ParseRing(benchmark::State& state)
+    {
+        const auto SCENARIO = static_cast<scenario_t>(state.range(0));
+        const auto STREAM   = rawStream(SCENARIO);
+
+        SerialRingHwa  hwa;
+        serial::Serial midi = serial::Serial(hwa);
+        SysExCounter   sysExCounter;
+        size_t         messages = 0;
+
+        midi.init();
+        midi.setSysExStream(&sysExCounter);
+
+        for (auto _ : state)
+        {
+            size_t index = 0;
+
+            while (index < STREAM.size())
+            {
+                index += hwa.rxBuffer().write(&STREAM[index], STREAM.size() - index);
+
+                while (midi.read())
+                {
+                    messages++;
+                }
+            }
+        }
+
+        setCounters(state, messages + sysExCounter._count, STREAM.size() * state.iterations());
+    }
+
+    void scenarios(benchmark::internal::Benchmark* benchmark)
+    {
+        benchmark->ArgName("scenario");
+
+        for (auto scenario : { scenario_t::DENSE_NOTES,
+                               scenario_t::RUNNING_STATUS,
+                               scenario_t::INTERLEAVED_CLOCK,
+                               scenario_t::LARGE_SYS_EX })
+        {
+            benchmark->Arg(static_cast<int64_t>(scenario));
+        }
+    }
+}    // namespace
+
+BENCHMARK_TEMPLATE(BM_Parse, SerialStack)->Apply(scenarios);
+BENCHMARK_TEMPLATE(BM_Parse, UsbStack)->Apply(scenarios);
+BENCHMARK_TEMPLATE(BM_Parse, BleStack)->Apply(scenarios);
+BENCHMARK(BM_ParseSpan)->Apply(scenarios);
+BENCHMARK(BM_ParseRing)->Apply(scenarios);
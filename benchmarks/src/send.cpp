@@ -0,0 +1,127 @@
+#include "benchmarks/common.h"
+
+using namespace benchmarks;
+using namespace lib::midi;
+
+namespace
+{
+    /// Sends the same message on every iteration.
+    /// Bytes are counted as the size of the message on serial line.
+    template<typename Stack, typename Send>
+    void send(benchmark::State& state, size_t messageSize, Send sendFunction)
+    {
+        Instance<Stack> instance;
+
+        if (!sendFunction(instance._midi))
+        {
+            state.SkipWithError("message not supported by transport");
+            return;
+        }
+
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(sendFunction(instance._midi));
+        }
+
+        setCounters(state, state.iterations(), messageSize * state.iterations());
+    }
+
+    template<typename Stack>
+    void BM_SendNoteOn(benchmark::State& state)
+    {
+        send<Stack>(state, 3, [](auto& midi)
+                    {
+                        return midi.sendNoteOn(60, 127, 1);
+                    });
+    }
+
+    template<typename Stack>
+    void BM_SendControlChange(benchmark::State& state)
+    {
+        send<Stack>(state, 3, [](auto& midi)
+                    {
+                        return midi.sendControlChange(7, 100, 1);
+                    });
+    }
+
+    template<typename Stack>
+    void BM_SendProgramChange(benchmark::State& state)
+    {
+        send<Stack>(state, 2, [](auto& midi)
+                    {
+                        return midi.sendProgramChange(5, 1);
+                    });
+    }
+
+    template<typename Stack>
+    void BM_SendPitchBend(benchmark::State& state)
+    {
+        send<Stack>(state, 3, [](auto& midi)
+                    {
+                        return midi.sendPitchBend(8192, 1);
+                    });
+    }
+
+    template<typename Stack>
+    void BM_SendNRPN(benchmark::State& state)
+    {
+        send<Stack>(state, 12, [](auto& midi)
+                    {
+                        return midi.sendNRPN(1000, 1000, 1, true);
+                    });
+    }
+
+    template<typename Stack>
+    void BM_SendRealTime(benchmark::State& state)
+    {
+        send<Stack>(state, 1, [](auto& midi)
+                    {
+                        return midi.sendRealTime(messageType_t::SYS_REAL_TIME_CLOCK);
+                    });
+    }
+
+    template<typename Stack>
+    void BM_SendSongPosition(benchmark::State& state)
+    {
+        send<Stack>(state, 3, [](auto& midi)
+                    {
+                        return midi.sendSongPosition(100);
+                    });
+    }
+
+    template<typename Stack>
+    void BM_SendSysEx(benchmark::State& state)
+    {
+        const std::vector<uint8_t> SYS_EX(state.range(0), 0x01);
+
+        send<Stack>(state, SYS_EX.size() + 2, [&](auto& midi)
+                    {
+                        return midi.sendSysEx(SYS_EX.size(), SYS_EX.data(), false);
+                    });
+    }
+}    // namespace
+
+BENCHMARK_TEMPLATE(BM_SendNoteOn, SerialStack);
+BENCHMARK_TEMPLATE(BM_SendNoteOn, UsbStack);
+BENCHMARK_TEMPLATE(BM_SendNoteOn, BleStack);
+BENCHMARK_TEMPLATE(BM_SendControlChange, SerialStack);
+BENCHMARK_TEMPLATE(BM_SendControlChange, UsbStack);
+BENCHMARK_TEMPLATE(BM_SendControlChange, BleStack);
+BENCHMARK_TEMPLATE(BM_SendProgramChange, SerialStack);
+BENCHMARK_TEMPLATE(BM_SendProgramChange, UsbStack);
+BENCHMARK_TEMPLATE(BM_SendProgramChange, BleStack);
+BENCHMARK_TEMPLATE(BM_SendPitchBend, SerialStack);
+BENCHMARK_TEMPLATE(BM_SendPitchBend, UsbStack);
+BENCHMARK_TEMPLATE(BM_SendPitchBend, BleStack);
+BENCHMARK_TEMPLATE(BM_SendNRPN, SerialStack);
+BENCHMARK_TEMPLATE(BM_SendNRPN, UsbStack);
+BENCHMARK_TEMPLATE(BM_SendNRPN, BleStack);
+BENCHMARK_TEMPLATE(BM_SendRealTime, SerialStack);
+BENCHMARK_TEMPLATE(BM_SendRealTime, UsbStack);
+BENCHMARK_TEMPLATE(BM_SendRealTime, BleStack);
+BENCHMARK_TEMPLATE(BM_SendSongPosition, SerialStack);
+BENCHMARK_TEMPLATE(BM_SendSongPosition, UsbStack);
+BENCHMARK_TEMPLATE(BM_SendSongPosition, BleStack);
+BENCHMARK_TEMPLATE(BM_SendSysEx, SerialStack)->Arg(16)->Arg(1024);
+BENCHMARK_TEMPLATE(BM_SendSysEx, UsbStack)->Arg(16)->Arg(1024);
+BENCHMARK_TEMPLATE(BM_SendSysEx, BleStack)->Arg(16)->Arg(1024);
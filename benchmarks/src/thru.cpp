@@ -0,0 +1,56 @@
+#include "benchmarks/common.h"
+
+using namespace benchmarks;
+using namespace lib::midi;
+
+namespace
+{
+    /// Reads dense note stream over serial and forwards it to the specified
+    /// amount of thru interfaces of the given transport type.
+    template<typename Stack>
+    void BM_Thru(benchmark::State& state)
+    {
+        const auto SCENARIO = scenario_t::DENSE_NOTES;
+
+        Instance<SerialStack>                                     source;
+        std::array<typename Stack::Hwa, MIDI_MAX_THRU_INTERFACES> hwa;
+        std::vector<typename Stack::Transport>                    destinations;
+        size_t                                                    messages = 0;
+
+        destinations.reserve(state.range(0));
+
+        for (int64_t i = 0; i < state.range(0); i++)
+        {
+            if constexpr (std::is_same_v<Stack, UsbStack>)
+            {
+                destinations.emplace_back(hwa[i], 0);
+            }
+            else
+            {
+                destinations.emplace_back(hwa[i]);
+            }
+
+            source._midi.registerThruInterface(destinations.back());
+        }
+
+        source._hwa.record(true);
+        generate(source._midi, SCENARIO);
+        source._hwa.record(false);
+
+        for (auto _ : state)
+        {
+            source._hwa.rewind();
+
+            while (source._midi.read())
+            {
+                messages++;
+            }
+        }
+
+        setCounters(state, messages, rawStream(SCENARIO).size() * state.iterations());
+    }
+}    // namespace
+
+BENCHMARK_TEMPLATE(BM_Thru, SerialStack)->ArgName("interfaces")->DenseRange(1, MIDI_MAX_THRU_INTERFACES);
+BENCHMARK_TEMPLATE(BM_Thru, UsbStack)->ArgName("interfaces")->DenseRange(1, MIDI_MAX_THRU_INTERFACES);
+BENCHMARK_TEMPLATE(BM_Thru, BleStack)->ArgName("interfaces")->DenseRange(1, MIDI_MAX_THRU_INTERFACES);
@@ -36,6 +36,31 @@
 #define MIDI_MAX_THRU_INTERFACES 5
 #endif
 
+/// Amount of decoded messages which can be stored by Base::poll() and Base::readAll().
+/// Queue is disabled when set to 0.
+#ifndef MIDI_MESSAGE_QUEUE_SIZE
+#define MIDI_MESSAGE_QUEUE_SIZE 0
+#endif
+
+/// Amount of outgoing messages which can be scheduled with Base::schedule() and Base::scheduleSysEx().
+/// Real Time messages are kept in a separate queue of the same size.
+/// Scheduling is disabled when set to 0.
+#ifndef MIDI_OUTPUT_QUEUE_SIZE
+#define MIDI_OUTPUT_QUEUE_SIZE 0
+#endif
+
+/// Enables runtime statistics (Base::stats() and stats() in every transport).
+/// When disabled, counters aren't stored nor updated.
+#ifndef MIDI_STATS
+#define MIDI_STATS 0
+#endif
+
+#if MIDI_STATS
+#define MIDI_STAT(statement) statement
+#else
+#define MIDI_STAT(statement)
+#endif
+
 namespace lib::midi
 {
     enum class messageType_t : uint8_t
@@ -72,7 +97,8 @@ namespace lib::midi
     enum class noteOffType_t : uint8_t
     {
         NOTE_ON_ZERO_VEL,
-        STANDARD_NOTE_OFF
+        STANDARD_NOTE_OFF,
+        KEEP_RUNNING_STATUS,    ///< Note On with velocity 0 if that avoids sending status byte, standard Note Off otherwise.
     };
 
     enum class note_t : uint8_t
@@ -92,16 +118,43 @@ namespace lib::midi
         AMOUNT
     };
 
+    enum class sysExChunk_t : uint8_t
+    {
+        START,       ///< First chunk of SysEx message, starts with 0xF0.
+        CONTINUE,    ///< Chunk in the middle of SysEx message.
+        END,         ///< Last chunk of SysEx message, ends with 0xF7.
+        COMPLETE,    ///< Entire SysEx message, used when the message fits in a single chunk.
+        ABORT        ///< Message was interrupted, chunks received so far should be discarded.
+    };
+
+    enum class readResult_t : uint8_t
+    {
+        NO_DATA,    ///< Nothing was received.
+        MESSAGE,    ///< Complete message was decoded.
+        RAW         ///< Received data must be read byte by byte and passed through the parser.
+    };
+
+    enum class parseError_t : uint8_t
+    {
+        MISSING_STATUS,      ///< Data byte received without preceding status byte.
+        UNDEFINED_STATUS,    ///< Undefined status byte (0xF4, 0xF5, 0xF9, 0xFD).
+        INTERRUPTED,         ///< Incomplete message dropped because of a new status byte.
+        STRAY_EOX,           ///< End of SysEx received without SysEx start.
+        SYS_EX_OVERFLOW,     ///< SysEx message longer than MIDI_SYSEX_ARRAY_SIZE.
+        AMOUNT
+    };
+
     /// Holds decoded data of a MIDI message.
+    /// SysEx payload isn't part of the message: it's stored separately and
+    /// retrieved with Base::sysExArray().
     struct Message
     {
-        uint8_t       channel                           = 1;
-        messageType_t type                              = messageType_t::INVALID;
-        uint8_t       data1                             = 0;
-        uint8_t       data2                             = 0;
-        uint8_t       sysexArray[MIDI_SYSEX_ARRAY_SIZE] = {};
-        bool          valid                             = false;    // validity implies that the message respects the MIDI norm
-        size_t        length                            = 0;
+        uint8_t       channel = 1;
+        messageType_t type    = messageType_t::INVALID;
+        uint8_t       data1   = 0;
+        uint8_t       data2   = 0;
+        uint16_t      length  = 0;
+        bool          valid   = false;    // validity implies that the message respects the MIDI norm
 
         Message() = default;
     };
@@ -263,12 +316,156 @@ namespace lib::midi
     constexpr uint8_t  MAX_VALUE_7BIT  = 127;
     constexpr uint16_t MAX_VALUE_14BIT = 16383;
 
+    /// Counters collected by MIDI instance when MIDI_STATS is enabled.
+    struct Stats
+    {
+        /// Amount of message types which are counted separately: channel messages by
+        /// type (channel is ignored) and every system message status.
+        static constexpr size_t MESSAGE_TYPES = 23;
+
+        uint32_t bytesIn                                                = 0;
+        uint32_t bytesOut                                               = 0;
+        uint32_t received[MESSAGE_TYPES]                                = {};
+        uint32_t sent[MESSAGE_TYPES]                                    = {};
+        uint32_t runningStatusIn                                        = 0;    ///< Messages received without status byte.
+        uint32_t runningStatusOut                                       = 0;    ///< Messages sent without status byte.
+        uint32_t parseErrors[static_cast<size_t>(parseError_t::AMOUNT)] = {};
+        uint32_t sendFailures                                           = 0;    ///< Messages which transport failed to send.
+        uint32_t thruDropped                                            = 0;    ///< Messages which thru interface failed to send.
+
+        /// Index of the message type in received and sent arrays.
+        static constexpr size_t index(messageType_t type)
+        {
+            const auto VALUE = static_cast<uint8_t>(type);
+
+            return (VALUE < 0xF0) ? ((VALUE >> 4) & 0x07) : ((VALUE & 0x0F) + 7);
+        }
+    };
+
+    /// Selects which messages are forwarded to a thru interface.
+    /// Filter is checked with a couple of bitwise operations before the interface is touched.
+    struct ThruFilter
+    {
+        static constexpr uint16_t ALL_CHANNELS = 0xFFFF;
+        static constexpr uint32_t ALL_TYPES    = (1UL << Stats::MESSAGE_TYPES) - 1;
+
+        uint16_t channels = ALL_CHANNELS;    ///< Bit N set: channel messages on channel N + 1 pass.
+        uint32_t types    = ALL_TYPES;       ///< Message types which pass, see typeBit().
+        uint8_t  remap    = 0;               ///< Channel to which channel messages are moved, 0 keeps the channel.
+        bool     raw      = false;           ///< Forward messages as they were received, running status included.
+
+        /// Bit of the message type in types mask.
+        static constexpr uint32_t typeBit(messageType_t type)
+        {
+            return 1UL << Stats::index(type);
+        }
+
+        /// Bit of the channel (1-16) in channels mask.
+        static constexpr uint16_t channelBit(uint8_t channel)
+        {
+            return static_cast<uint16_t>(1U << ((channel - 1) & 0x0F));
+        }
+    };
+
+    /// Counters collected by transport interfaces when MIDI_STATS is enabled.
+    /// For serial transport, every byte is counted as a packet.
+    struct TransportStats
+    {
+        uint32_t packetsIn        = 0;
+        uint32_t packetsOut       = 0;
+        uint32_t hwaWriteFailures = 0;
+        uint32_t invalidPackets   = 0;    ///< Received packets which were discarded.
+
+        void written(bool result, size_t packets = 1)
+        {
+            if (result)
+            {
+                packetsOut += packets;
+            }
+            else
+            {
+                hwaWriteFailures++;
+            }
+        }
+    };
+
+    /// Continuous block of data. Used to send data stored in several separate buffers at once.
+    struct Segment
+    {
+        const uint8_t* data = nullptr;
+        size_t         size = 0;
+    };
+
+    /// Interface receiving messages decoded from raw byte buffers.
+    class Sink
+    {
+        public:
+        virtual void process(const Message& message) = 0;
+    };
+
+    /// Interface receiving SysEx messages in chunks while they are being received.
+    /// Chunk data is valid only until the function returns.
+    class SysExStream
+    {
+        public:
+        virtual void sysExChunk(sysExChunk_t type, const uint8_t* data, size_t size) = 0;
+    };
+
     class Thru
     {
         public:
         virtual bool beginTransmission(messageType_t type) = 0;
         virtual bool write(uint8_t data)                   = 0;
         virtual bool endTransmission()                     = 0;
+
+        /// Writes block of data as a part of the current transmission.
+        /// Interfaces which can pack several bytes at once should override this.
+        virtual bool write(const uint8_t* data, size_t size)
+        {
+            for (size_t i = 0; i < size; i++)
+            {
+                if (!write(data[i]))
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        /// Sends out any data buffered by the interface.
+        /// Interfaces which don't send every message immediately should override this.
+        virtual bool flush()
+        {
+            return true;
+        }
+
+        /// Checks whether the interface transfers plain MIDI byte stream. Status byte of a channel
+        /// message can then be omitted when it's the same as in the previous one (running status),
+        /// and SysEx message can be sent in several parts, with Real Time bytes between them.
+        /// Interfaces which always need complete messages, such as packet-based ones, should override this.
+        virtual bool byteStream()
+        {
+            return true;
+        }
+
+        /// Retrieves status byte of the last channel message written to the interface, or
+        /// messageType_t::INVALID if the running status of the receiver isn't known.
+        /// It's kept here rather than by the writer so that every MIDI instance which sends or forwards
+        /// messages to the same interface omits status bytes based on what was actually transmitted.
+        uint8_t runningStatus() const
+        {
+            return _runningStatus;
+        }
+
+        /// Updates running status after a message is written to the interface.
+        void setRunningStatus(uint8_t status)
+        {
+            _runningStatus = status;
+        }
+
+        private:
+        uint8_t _runningStatus = static_cast<uint8_t>(messageType_t::INVALID);
     };
 
     class Transport : public Thru
@@ -277,5 +474,46 @@ namespace lib::midi
         virtual bool init()              = 0;
         virtual bool deInit()            = 0;
         virtual bool read(uint8_t& data) = 0;
+
+        /// Reads up to the specified amount of bytes at once.
+        /// Interfaces which can retrieve several bytes at once should override this.
+        /// returns: Amount of read bytes.
+        virtual size_t read(uint8_t* data, size_t size)
+        {
+            size_t count = 0;
+
+            while ((count < size) && read(data[count]))
+            {
+                count++;
+            }
+
+            return count;
+        }
+
+        /// Decodes complete message directly from received packet, without using the byte parser.
+        /// Interfaces whose packets hold entire messages should override this.
+        /// param message [in,out]     Decoded message, modified only if readResult_t::MESSAGE is returned.
+        /// returns: readResult_t::RAW if the data should be read with read() instead.
+        virtual readResult_t readMessage(Message&)
+        {
+            return readResult_t::RAW;
+        }
+
+        /// Retrieves the time at which the last read byte was sent.
+        /// Interfaces which transfer timestamps along with MIDI data should override this.
+        /// returns: Timestamp in the same units as used by the interface, or 0 if not available.
+        virtual uint32_t timestamp()
+        {
+            return 0;
+        }
+
+        /// Blocks until new data can be read or until the timeout passes.
+        /// Interfaces which can be notified about received data should override this.
+        /// param timeout [in,out]    Maximum time to wait, in milliseconds, decreased by the time spent waiting.
+        /// returns: True if data may be available, false on timeout or if waiting isn't supported.
+        virtual bool wait(uint32_t&)
+        {
+            return false;
+        }
     };
 }    // namespace lib::midi
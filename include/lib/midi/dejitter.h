@@ -0,0 +1,60 @@
+/*
+    Copyright 2022 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "common.h"
+
+/// Amount of messages which can be held by Dejitter.
+#ifndef MIDI_DEJITTER_BUFFER_SIZE
+#define MIDI_DEJITTER_BUFFER_SIZE 32
+#endif
+
+namespace lib::midi
+{
+    /// Releases received messages on a steady schedule.
+    /// Transports such as BLE deliver messages in batches, once per connection interval,
+    /// which shows up as jitter when messages are handled as soon as they're read.
+    /// Every message pushed here is held until the specified delay has passed since
+    /// its timestamp, so the timing between messages is restored at the cost of constant latency.
+    /// Delay should be longer than the largest expected latency of the transport.
+    /// Only messages are stored: payload of SysEx messages should be handled once read.
+    class Dejitter
+    {
+        public:
+        Dejitter(uint32_t delay)
+            : _delay(delay)
+        {}
+
+        bool   push(const Message& message, uint32_t timestamp);
+        bool   pop(uint32_t time, Message& message);
+        size_t size();
+        void   clear();
+        void   setDelay(uint32_t delay);
+
+        private:
+        uint32_t                                        _delay      = 0;
+        std::array<Message, MIDI_DEJITTER_BUFFER_SIZE>  _buffer     = {};
+        std::array<uint32_t, MIDI_DEJITTER_BUFFER_SIZE> _timestamps = {};
+        size_t                                          _head       = 0;
+        size_t                                          _count      = 0;
+    };
+}    // namespace lib::midi
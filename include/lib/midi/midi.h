@@ -23,13 +23,19 @@
 #pragma once
 
 #include "common.h"
+#include "ring.h"
 
 namespace lib::midi
 {
-    class Base
+    /// MIDI instance bound to a specific transport type at compile time.
+    /// When TransportT is a final class, calls to the transport aren't dispatched through vtable.
+    /// Member functions are defined in midi.cpp and instantiated for Transport and for
+    /// all the transports provided by the library.
+    template<typename TransportT>
+    class BasicMidi
     {
         public:
-        Base(Transport& transport)
+        BasicMidi(TransportT& transport)
             : _transport(transport)
         {}
 
@@ -37,7 +43,7 @@ namespace lib::midi
         bool          deInit();
         bool          initialized();
         void          reset();
-        Transport&    transport();
+        TransportT&   transport();
         bool          sendNoteOn(uint8_t inNoteNumber, uint8_t inVelocity, uint8_t inChannel);
         bool          sendNoteOff(uint8_t inNoteNumber, uint8_t inVelocity, uint8_t inChannel);
         bool          sendProgramChange(uint8_t inProgramNumber, uint8_t inChannel);
@@ -47,19 +53,39 @@ namespace lib::midi
         bool          sendAfterTouch(uint8_t inPressure, uint8_t inChannel, uint8_t inNoteNumber);
         bool          sendAfterTouch(uint8_t inPressure, uint8_t inChannel);
         bool          sendSysEx(uint16_t inLength, const uint8_t* inArray, bool inArrayContainsBoundaries);
+        bool          sendSysEx(const Segment* segments, size_t count, bool inArrayContainsBoundaries);
         bool          sendTimeCodeQuarterFrame(uint8_t inTypeNibble, uint8_t inValuesNibble);
         bool          sendTimeCodeQuarterFrame(uint8_t inData);
         bool          sendSongPosition(uint16_t inBeats);
         bool          sendSongSelect(uint8_t inSongNumber);
         bool          sendTuneRequest();
-        bool          sendCommon(messageType_t inType, uint8_t inData1 = 0);
+        bool          sendCommon(messageType_t inType, uint16_t inData1 = 0);
         bool          sendRealTime(messageType_t inType);
+        bool          injectRealTime(messageType_t inType);
+        bool          sendPendingRealTime();
         bool          sendMMC(uint8_t deviceID, messageType_t mmc);
         bool          sendNRPN(uint16_t inParameterNumber, uint16_t inValue, uint8_t inChannel, bool value14bit = false);
         bool          send(messageType_t inType, uint8_t inData1, uint8_t inData2, uint8_t inChannel);
+        bool          send(const Message& message);
+        bool          flush();
         bool          read();
+        bool          read(uint32_t timeout);
+        size_t        readAll();
+        size_t        poll(size_t maxMessages);
+        size_t        queued();
+        Message&      queuedMessage(size_t index);
+        bool          pop(Message& message);
+        void          clearQueue();
+        bool          schedule(const Message& message, uint32_t time);
+        bool          scheduleSysEx(const uint8_t* data, uint16_t length, uint32_t time);
+        size_t        tick(uint32_t time);
+        size_t        scheduled();
+        void          clearSchedule();
+        void          setSysExChunkSize(uint16_t size);
         bool          parse();
+        size_t        parse(const uint8_t* data, size_t size, Sink& sink);
         void          useRecursiveParsing(bool state);
+        void          setSysExStream(SysExStream* stream);
         bool          runningStatusState();
         noteOffType_t noteOffMode();
         messageType_t type();
@@ -68,27 +94,95 @@ namespace lib::midi
         uint8_t       data2();
         uint8_t*      sysExArray();
         uint16_t      length();
+        uint32_t      timestamp();
         void          setRunningStatusState(bool state);
+        void          setRunningStatusRefresh(uint16_t bytes);
+        void          refreshRunningStatus();
         void          setNoteOffMode(noteOffType_t type);
-        void          registerThruInterface(Thru& interface);
+        void          registerThruInterface(Thru& interface, const ThruFilter& filter = {});
+        bool          setThruFilter(Thru& interface, const ThruFilter& filter);
         void          unregisterThruInterface(Thru& interface);
         Message&      message();
 
+#if MIDI_STATS
+        Stats stats();
+        void  clearStats();
+#endif
+
         private:
-        Transport&                                  _transport;
-        Message                                     _message                      = {};
-        bool                                        _initialized                  = false;
-        bool                                        _useRunningStatus             = false;
-        bool                                        _recursiveParseState          = false;
-        uint8_t                                     _mRunningStatusRX             = 0;
-        uint8_t                                     _mRunningStatusTX             = 0;
-        uint8_t                                     _mPendingMessage[3]           = {};
-        uint16_t                                    _pendingMessageExpectedLength = 0;
-        uint16_t                                    _pendingMessageIndex          = 0;
-        noteOffType_t                               _noteOffMode                  = noteOffType_t::NOTE_ON_ZERO_VEL;
-        std::array<Thru*, MIDI_MAX_THRU_INTERFACES> _thruInterface                = {};
+        /// Outgoing message waiting in the output queue.
+        struct ScheduledEvent
+        {
+            Message        message  = {};
+            const uint8_t* data     = nullptr;    // SysEx payload, including boundaries
+            uint32_t       time     = 0;
+            uint32_t       sequence = 0;          // keeps the order of messages scheduled for the same time
+        };
+
+        TransportT&                                        _transport;
+        Message                                            _message                      = {};
+        uint32_t                                           _timestamp                    = 0;
+        bool                                               _initialized                  = false;
+        bool                                               _useRunningStatus             = false;
+        bool                                               _recursiveParseState          = false;
+        uint8_t                                            _mRunningStatusRX             = 0;
+        bool                                               _rxRunningStatus              = false;
+        uint16_t                                           _runningStatusRefresh         = 0;
+        uint16_t                                           _runningStatusBytes           = 0;
+        uint8_t                                            _mPendingMessage[3]           = {};
+        uint16_t                                           _pendingMessageExpectedLength = 0;
+        uint16_t                                           _pendingMessageIndex          = 0;
+        SysExStream*                                       _sysExStream                  = nullptr;
+        bool                                               _sysExStreamActive            = false;
+        noteOffType_t                                      _noteOffMode                  = noteOffType_t::NOTE_ON_ZERO_VEL;
+        std::array<Thru*, MIDI_MAX_THRU_INTERFACES>        _thruInterface                = {};
+        std::array<ThruFilter, MIDI_MAX_THRU_INTERFACES>   _thruFilter                   = {};
+        std::array<uint8_t, MIDI_SYSEX_ARRAY_SIZE>         _sysExArray                   = {};
+        std::array<Message, MIDI_MESSAGE_QUEUE_SIZE>       _queue                        = {};
+        size_t                                             _queueHead                    = 0;
+        size_t                                             _queueCount                   = 0;
+        std::array<ScheduledEvent, MIDI_OUTPUT_QUEUE_SIZE> _schedule                     = {};
+        size_t                                             _scheduleCount                = 0;
+        std::array<ScheduledEvent, MIDI_OUTPUT_QUEUE_SIZE> _realTimeSchedule             = {};
+        size_t                                             _realTimeScheduleCount        = 0;
+        uint32_t                                           _scheduleSequence             = 0;
+        const uint8_t*                                     _sysExData                    = nullptr;
+        uint16_t                                           _sysExRemaining               = 0;
+        uint16_t                                           _sysExChunkSize               = 0;
+        Ring<8>                                            _pendingRealTime              = {};
+
+#if MIDI_STATS
+        Stats _stats = {};
+#endif
+
+        bool           omitStatus(uint8_t status);
+        bool           beginTransmission(messageType_t type);
+        bool           write(uint8_t data);
+        bool           write(const uint8_t* data, size_t size);
+        bool           endTransmission(messageType_t type);
+        readResult_t   receive();
+        void           acceptMessage();
+        bool           parseByte(uint8_t data);
+        void           abortSysExStream();
+        void           thru();
+        uint8_t        status(messageType_t inType, uint8_t inChannel);
+        bool           enqueue(std::array<ScheduledEvent, MIDI_OUTPUT_QUEUE_SIZE>& queue, size_t& count, ScheduledEvent& event);
+        ScheduledEvent dequeue(std::array<ScheduledEvent, MIDI_OUTPUT_QUEUE_SIZE>& queue, size_t& count);
+        bool           sendScheduled(const ScheduledEvent& event);
+        bool           sendSysExChunk();
+        bool           writePendingRealTime();
+
+        static bool later(const ScheduledEvent& first, const ScheduledEvent& second);
+    };
 
-        void    thru();
-        uint8_t status(messageType_t inType, uint8_t inChannel);
+    /// MIDI instance which can be used with any Transport implementation.
+    class Base : public BasicMidi<Transport>
+    {
+        public:
+        Base(Transport& transport)
+            : BasicMidi(transport)
+        {}
     };
+
+    extern template class BasicMidi<Transport>;
 }    // namespace lib::midi
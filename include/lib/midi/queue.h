@@ -0,0 +1,257 @@
+/*
+    Copyright 2022 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <stddef.h>
+#include <inttypes.h>
+#include "midi.h"
+
+/// Size of the cache line on the target. Producer and consumer state of Queue
+/// are kept in separate cache lines so that the two sides don't invalidate each other.
+#ifndef MIDI_CACHE_LINE_SIZE
+#define MIDI_CACHE_LINE_SIZE 64
+#endif
+
+namespace lib::midi
+{
+    /// Compact form of a MIDI message passed between threads.
+    /// SysEx messages can't be represented.
+    struct Event
+    {
+        uint32_t timestamp = 0;
+        uint8_t  status    = 0;    // status byte, channel included
+        uint8_t  data1     = 0;
+        uint8_t  data2     = 0;
+        uint8_t  length    = 0;
+
+        static Event fromMessage(const Message& message, uint32_t timestamp = 0)
+        {
+            Event event;
+
+            event.timestamp = timestamp;
+            event.status    = IS_CHANNEL_MESSAGE(message.type) ? static_cast<uint8_t>(static_cast<uint8_t>(message.type) | ((message.channel - 1) & 0x0F))
+                                                               : static_cast<uint8_t>(message.type);
+            event.data1     = message.data1;
+            event.data2     = message.data2;
+            event.length    = static_cast<uint8_t>(message.length);
+
+            return event;
+        }
+
+        Message toMessage() const
+        {
+            Message message;
+
+            message.type    = TYPE_FROM_STATUS_BYTE(status);
+            message.channel = IS_CHANNEL_MESSAGE(message.type) ? CHANNEL_FROM_STATUS_BYTE(status) : 0;
+            message.data1   = data1;
+            message.data2   = data2;
+            message.length  = length;
+            message.valid   = true;
+
+            return message;
+        }
+    };
+
+    static_assert(sizeof(Event) == 8, "Event should fit in 8 bytes");
+
+    /// Allocation-free queue with single producer and single consumer, for instance
+    /// thread reading the transport on one side and the application thread on the other.
+    /// Every side keeps a copy of the index owned by the other side and reloads it only
+    /// when the copy says that the queue is full or empty, so a transfer usually costs
+    /// a single atomic load and store.
+    /// Size must be a power of two.
+    template<typename T, size_t Size>
+    class Queue
+    {
+        static_assert(Size && !(Size & (Size - 1)), "Queue size must be a power of two");
+
+        public:
+        /// Producer side: stores single element.
+        /// returns: False if the queue is full, true otherwise.
+        bool push(const T& element)
+        {
+            const size_t HEAD = _head.load(std::memory_order_relaxed);
+
+            if ((HEAD - _tailCopy) == Size)
+            {
+                _tailCopy = _tail.load(std::memory_order_acquire);
+
+                if ((HEAD - _tailCopy) == Size)
+                {
+                    return false;
+                }
+            }
+
+            _buffer[HEAD & MASK] = element;
+            _head.store(HEAD + 1, std::memory_order_release);
+
+            return true;
+        }
+
+        /// Consumer side: retrieves single element.
+        /// returns: False if the queue is empty, true otherwise.
+        bool pop(T& element)
+        {
+            const size_t TAIL = _tail.load(std::memory_order_relaxed);
+
+            if (TAIL == _headCopy)
+            {
+                _headCopy = _head.load(std::memory_order_acquire);
+
+                if (TAIL == _headCopy)
+                {
+                    return false;
+                }
+            }
+
+            element = _buffer[TAIL & MASK];
+            _tail.store(TAIL + 1, std::memory_order_release);
+
+            return true;
+        }
+
+        /// Retrieves the amount of stored elements.
+        /// Value is only approximate while the other side is active.
+        size_t size() const
+        {
+            return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+        }
+
+        /// Retrieves the maximum amount of elements which can be stored.
+        static constexpr size_t capacity()
+        {
+            return Size;
+        }
+
+        private:
+        static constexpr size_t MASK = Size - 1;
+
+        alignas(MIDI_CACHE_LINE_SIZE) std::atomic<size_t> _head     = 0;
+        size_t                                            _tailCopy = 0;    // producer side
+        alignas(MIDI_CACHE_LINE_SIZE) std::atomic<size_t> _tail     = 0;
+        size_t                                            _headCopy = 0;    // consumer side
+        alignas(MIDI_CACHE_LINE_SIZE) std::array<T, Size> _buffer   = {};
+    };
+
+    template<size_t Size>
+    using EventQueue = Queue<Event, Size>;
+
+    /// Producer side adapter: stores messages decoded by MIDI instance into the queue.
+    /// Can also be passed as a sink to BasicMidi::parse(). SysEx messages are skipped.
+    template<typename MidiT, size_t Size>
+    class QueueReader : public Sink
+    {
+        public:
+        QueueReader(MidiT& midi, EventQueue<Size>& queue)
+            : _midi(midi)
+            , _queue(queue)
+        {}
+
+        /// Reads all the messages currently available from the MIDI instance.
+        /// Thru interfaces registered to the instance are used as with read().
+        /// returns: Amount of messages stored into the queue.
+        size_t update()
+        {
+            size_t count = 0;
+
+            while (_midi.read())
+            {
+                count += store(_midi.message(), _midi.timestamp());
+            }
+
+            return count;
+        }
+
+        void process(const Message& message) override
+        {
+            store(message, 0);
+        }
+
+#if MIDI_STATS
+        /// Retrieves the amount of messages which were dropped because the queue was full.
+        uint32_t dropped() const
+        {
+            return _dropped;
+        }
+#endif
+
+        private:
+        MidiT&            _midi;
+        EventQueue<Size>& _queue;
+
+#if MIDI_STATS
+        uint32_t _dropped = 0;
+#endif
+
+        bool store(const Message& message, uint32_t timestamp)
+        {
+            if (message.type == messageType_t::SYS_EX)
+            {
+                return false;
+            }
+
+            if (!_queue.push(Event::fromMessage(message, timestamp)))
+            {
+                MIDI_STAT(_dropped++);
+                return false;
+            }
+
+            return true;
+        }
+    };
+
+    /// Consumer side adapter: sends events stored in the queue with MIDI instance.
+    /// With several producer threads, use one queue and one writer per thread,
+    /// and update all the writers from the thread which owns the MIDI instance.
+    template<typename MidiT, size_t Size>
+    class QueueWriter
+    {
+        public:
+        QueueWriter(MidiT& midi, EventQueue<Size>& queue)
+            : _midi(midi)
+            , _queue(queue)
+        {}
+
+        /// Sends all the events currently stored in the queue.
+        /// returns: Amount of successfully sent events.
+        size_t update()
+        {
+            size_t count = 0;
+            Event  event;
+
+            while (_queue.pop(event))
+            {
+                count += _midi.send(event.toMessage());
+            }
+
+            return count;
+        }
+
+        private:
+        MidiT&            _midi;
+        EventQueue<Size>& _queue;
+    };
+}    // namespace lib::midi
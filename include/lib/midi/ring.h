@@ -0,0 +1,163 @@
+/*
+    Copyright 2022 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <stddef.h>
+#include <inttypes.h>
+
+namespace lib::midi
+{
+    /// Lock-free byte queue with single producer and single consumer, for instance
+    /// interrupt routine or DMA on one side and the application on the other.
+    /// Producer only modifies head and consumer only modifies tail, so no locking is
+    /// needed as long as each side is used from a single context.
+    /// Contiguous regions of the buffer are exposed so that the data can be
+    /// transferred with DMA or passed on as spans.
+    /// Size must be a power of two.
+    template<size_t Size>
+    class Ring
+    {
+        static_assert(Size && !(Size & (Size - 1)), "Ring size must be a power of two");
+
+        public:
+        /// Producer side: stores single byte.
+        /// returns: False if the buffer is full, true otherwise.
+        bool push(uint8_t data)
+        {
+            const size_t HEAD = _head.load(std::memory_order_relaxed);
+
+            if ((HEAD - _tail.load(std::memory_order_acquire)) == Size)
+            {
+                return false;
+            }
+
+            _buffer[HEAD & MASK] = data;
+            _head.store(HEAD + 1, std::memory_order_release);
+
+            return true;
+        }
+
+        /// Producer side: stores as many bytes as there is room for.
+        /// returns: Amount of stored bytes.
+        size_t write(const uint8_t* data, size_t size)
+        {
+            const size_t HEAD  = _head.load(std::memory_order_relaxed);
+            const size_t COUNT = std::min(size, Size - (HEAD - _tail.load(std::memory_order_acquire)));
+            const size_t FIRST = std::min(COUNT, Size - (HEAD & MASK));
+
+            memcpy(&_buffer[HEAD & MASK], data, FIRST);
+            memcpy(&_buffer[0], &data[FIRST], COUNT - FIRST);
+            _head.store(HEAD + COUNT, std::memory_order_release);
+
+            return COUNT;
+        }
+
+        /// Producer side: retrieves contiguous free region, for instance to be filled with DMA.
+        /// Region must be committed with commit() once filled.
+        /// param size [out]   Size of the region.
+        uint8_t* writeSpan(size_t& size)
+        {
+            const size_t HEAD = _head.load(std::memory_order_relaxed);
+
+            size = std::min(Size - (HEAD - _tail.load(std::memory_order_acquire)), Size - (HEAD & MASK));
+            return &_buffer[HEAD & MASK];
+        }
+
+        /// Producer side: makes the specified amount of bytes written into writeSpan() available to the consumer.
+        void commit(size_t size)
+        {
+            _head.store(_head.load(std::memory_order_relaxed) + size, std::memory_order_release);
+        }
+
+        /// Consumer side: retrieves single byte.
+        /// returns: False if the buffer is empty, true otherwise.
+        bool pop(uint8_t& data)
+        {
+            const size_t TAIL = _tail.load(std::memory_order_relaxed);
+
+            if (TAIL == _head.load(std::memory_order_acquire))
+            {
+                return false;
+            }
+
+            data = _buffer[TAIL & MASK];
+            _tail.store(TAIL + 1, std::memory_order_release);
+
+            return true;
+        }
+
+        /// Consumer side: retrieves up to the specified amount of bytes.
+        /// returns: Amount of retrieved bytes.
+        size_t read(uint8_t* data, size_t size)
+        {
+            const size_t TAIL  = _tail.load(std::memory_order_relaxed);
+            const size_t COUNT = std::min(size, _head.load(std::memory_order_acquire) - TAIL);
+            const size_t FIRST = std::min(COUNT, Size - (TAIL & MASK));
+
+            memcpy(data, &_buffer[TAIL & MASK], FIRST);
+            memcpy(&data[FIRST], &_buffer[0], COUNT - FIRST);
+            _tail.store(TAIL + COUNT, std::memory_order_release);
+
+            return COUNT;
+        }
+
+        /// Consumer side: retrieves contiguous region of stored data, for instance to be sent with DMA.
+        /// Region must be released with consume() once the data isn't needed anymore.
+        /// param size [out]   Size of the region.
+        const uint8_t* readSpan(size_t& size)
+        {
+            const size_t TAIL = _tail.load(std::memory_order_relaxed);
+
+            size = std::min(_head.load(std::memory_order_acquire) - TAIL, Size - (TAIL & MASK));
+            return &_buffer[TAIL & MASK];
+        }
+
+        /// Consumer side: releases the specified amount of bytes retrieved with readSpan().
+        void consume(size_t size)
+        {
+            _tail.store(_tail.load(std::memory_order_relaxed) + size, std::memory_order_release);
+        }
+
+        /// Retrieves the amount of stored bytes.
+        size_t size() const
+        {
+            return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+        }
+
+        /// Retrieves the maximum amount of bytes which can be stored.
+        static constexpr size_t capacity()
+        {
+            return Size;
+        }
+
+        private:
+        static constexpr size_t MASK = Size - 1;
+
+        std::array<uint8_t, Size> _buffer = {};
+        std::atomic<size_t>       _head   = 0;
+        std::atomic<size_t>       _tail   = 0;
+    };
+}    // namespace lib::midi
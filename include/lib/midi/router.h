@@ -0,0 +1,145 @@
+/*
+    Copyright 2022 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include "queue.h"
+
+/// Maximum amount of ports handled by Router, up to 64.
+#ifndef MIDI_ROUTER_MAX_PORTS
+#define MIDI_ROUTER_MAX_PORTS 16
+#endif
+
+/// Maximum amount of workers among which Router ports are shared.
+#ifndef MIDI_ROUTER_MAX_WORKERS
+#define MIDI_ROUTER_MAX_WORKERS 2
+#endif
+
+/// Amount of messages which can be pending between any two workers, must be a power of two.
+#ifndef MIDI_ROUTER_QUEUE_SIZE
+#define MIDI_ROUTER_QUEUE_SIZE 32
+#endif
+
+/// Default maximum amount of messages read from a single port in one Router update,
+/// so that a busy port can't hold back the other ports of the same worker.
+#ifndef MIDI_ROUTER_BATCH_SIZE
+#define MIDI_ROUTER_BATCH_SIZE 8
+#endif
+
+namespace lib::midi
+{
+    /// Forwards messages between a number of MIDI instances.
+    /// Every port is owned by a single worker: only that worker reads from and sends to the port,
+    /// so MIDI instances don't need any locking. Router doesn't create threads on its own:
+    /// application calls update() for every worker from its own thread or task.
+    /// Messages for ports owned by the same worker are sent at once, while messages for
+    /// ports owned by other workers are passed on through lock-free queue, one for every pair of workers.
+    /// Ports, routes and worker assignments should only be changed while the workers are stopped.
+    /// SysEx messages aren't forwarded.
+    class Router
+    {
+        public:
+        /// Interface through which router reads and sends messages.
+        class Port
+        {
+            public:
+            virtual bool read(Message& message)       = 0;
+            virtual bool send(const Message& message) = 0;
+        };
+
+        /// Port backed by MIDI instance.
+        template<typename MidiT>
+        class MidiPort : public Port
+        {
+            public:
+            MidiPort(MidiT& midi)
+                : _midi(midi)
+            {}
+
+            bool read(Message& message) override
+            {
+                if (!_midi.read())
+                {
+                    return false;
+                }
+
+                message = _midi.message();
+                return true;
+            }
+
+            bool send(const Message& message) override
+            {
+                return _midi.send(message);
+            }
+
+            private:
+            MidiT& _midi;
+        };
+
+        /// Counters describing the traffic of a single port, used to balance ports among workers.
+        struct Load
+        {
+            uint32_t received = 0;    ///< Messages read from the port.
+            uint32_t sent     = 0;    ///< Messages sent to the port.
+            uint32_t dropped  = 0;    ///< Messages for the port which were dropped because the queue was full.
+        };
+
+        static constexpr size_t INVALID_PORT = MIDI_ROUTER_MAX_PORTS;
+
+        size_t addPort(Port& port, size_t worker);
+        size_t ports();
+        bool   assign(size_t port, size_t worker);
+        size_t worker(size_t port);
+        bool   connect(size_t source, size_t destination);
+        bool   disconnect(size_t source, size_t destination);
+        size_t update(size_t worker, size_t maxMessages = MIDI_ROUTER_BATCH_SIZE);
+        Load   load(size_t port);
+
+        private:
+        static_assert(MIDI_ROUTER_MAX_PORTS <= 64, "Router supports up to 64 ports");
+
+        /// Message travelling between workers.
+        struct RoutedEvent
+        {
+            Event   event = {};
+            uint8_t port  = 0;    // destination
+        };
+
+        struct PortState
+        {
+            Port*                 port     = nullptr;
+            size_t                worker   = 0;
+            uint64_t              routes   = 0;    // bit N set: messages are forwarded to port N
+            std::atomic<uint32_t> received = 0;
+            std::atomic<uint32_t> sent     = 0;
+            std::atomic<uint32_t> dropped  = 0;
+        };
+
+        using WorkerQueue = Queue<RoutedEvent, MIDI_ROUTER_QUEUE_SIZE>;
+
+        std::array<PortState, MIDI_ROUTER_MAX_PORTS>                               _ports     = {};
+        size_t                                                                     _portCount = 0;
+        std::array<WorkerQueue, MIDI_ROUTER_MAX_WORKERS * MIDI_ROUTER_MAX_WORKERS> _queues    = {};
+
+        void deliver(size_t port, const Message& message);
+    };
+}    // namespace lib::midi
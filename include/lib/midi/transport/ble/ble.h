@@ -26,39 +26,96 @@
 
 namespace lib::midi::ble
 {
-    class Ble : public Base
+    class Transport final : public lib::midi::Transport
     {
         public:
-        Ble(Hwa& hwa)
-            : Base(_transport)
-            , _transport(*this)
-            , _hwa(hwa)
+        Transport(Hwa& hwa)
+            : _hwa(hwa)
         {}
 
+        bool     init() override;
+        bool     deInit() override;
+        bool     beginTransmission(messageType_t type) override;
+        bool     write(uint8_t data) override;
+        bool     write(const uint8_t* data, size_t size) override;
+        bool     endTransmission() override;
+        bool     read(uint8_t& data) override;
+        size_t   read(uint8_t* data, size_t size) override;
+        uint32_t timestamp() override;
+        bool     flush() override;
+        bool     byteStream() override;
+        bool     wait(uint32_t& timeout) override;
+        void     setPacking(bool state, uint32_t maxLatency);
+
+#if MIDI_STATS
+        TransportStats stats();
+#endif
+
         private:
-        class Transport : public lib::midi::Transport
+        Hwa&                                           _hwa;
+        Packet                                         _txBuffer        = {};
+        size_t                                         _packetSize      = MIDI_BLE_MAX_PACKET_SIZE;
+        size_t                                         _rxIndex         = 0;
+        size_t                                         _retrieveIndex   = 0;
+        std::array<uint8_t, MIDI_BLE_MAX_PACKET_SIZE>  _rxBuffer        = {};
+        uint8_t                                        _lowTimestamp    = 0;
+        messageType_t                                  _activeType      = messageType_t::INVALID;
+        bool                                           _packing         = false;
+        uint32_t                                       _maxLatency      = 0;
+        uint32_t                                       _packetTime      = 0;
+        size_t                                         _messageStart    = 0;
+        uint8_t                                        _txRunningStatus = 0;
+        bool                                           _statusOmitted   = false;
+        std::array<uint32_t, MIDI_BLE_MAX_PACKET_SIZE> _rxTime          = {};
+        uint32_t                                       _rxTimestamp     = 0;
+        uint32_t                                       _readTimestamp   = 0;
+        uint32_t                                       _timeOffset      = 0;
+        uint32_t                                       _offsetTime      = 0;
+        bool                                           _timeOffsetValid = false;
+
+#if MIDI_STATS
+        TransportStats _stats = {};
+#endif
+
+        bool     receive();
+        bool     append(uint8_t data);
+        bool     continuePacket();
+        bool     movePacket();
+        uint32_t alignTimestamp(uint16_t timestamp, uint32_t time);
+    };
+
+    class Ble : public BasicMidi<Transport>
+    {
+        public:
+        Ble(Hwa& hwa)
+            : BasicMidi(_transport)
+            , _transport(hwa)
         {
-            public:
-            Transport(Ble& ble)
-                : _ble(ble)
-            {}
-
-            bool init() override;
-            bool deInit() override;
-            bool beginTransmission(messageType_t type) override;
-            bool write(uint8_t data) override;
-            bool endTransmission() override;
-            bool read(uint8_t& data) override;
-
-            private:
-            Ble&                                          _ble;
-            Packet                                        _txBuffer      = {};
-            size_t                                        _rxIndex       = 0;
-            size_t                                        _retrieveIndex = 0;
-            std::array<uint8_t, MIDI_BLE_MAX_PACKET_SIZE> _rxBuffer      = {};
-            uint8_t                                       _lowTimestamp  = 0;
-        } _transport;
-
-        Hwa& _hwa;
+            useRecursiveParsing(true);
+        }
+
+        private:
+        Transport _transport;
     };
-}    // namespace lib::midi::ble
\ No newline at end of file
+
+    /// Same as Ble, but derived from Base so that it can be passed to code which takes lib::midi::Base&.
+    /// Calls to the transport are dispatched through vtable.
+    class BleBase : public Base
+    {
+        public:
+        BleBase(Hwa& hwa)
+            : Base(_transport)
+            , _transport(hwa)
+        {
+            useRecursiveParsing(true);
+        }
+
+        private:
+        Transport _transport;
+    };
+}    // namespace lib::midi::ble
+
+namespace lib::midi
+{
+    extern template class BasicMidi<ble::Transport>;
+}    // namespace lib::midi
\ No newline at end of file
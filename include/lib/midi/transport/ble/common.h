@@ -25,6 +25,8 @@
 #include <stddef.h>
 #include <inttypes.h>
 
+/// Maximum size of BLE MIDI packet. Packets are sized according to the MTU reported
+/// by Hwa::mtu(), up to this size. Set to 244 to make use of the largest common MTU of 247 bytes.
 #ifndef MIDI_BLE_MAX_PACKET_SIZE
 #define MIDI_BLE_MAX_PACKET_SIZE 64
 #endif
@@ -45,5 +47,29 @@ namespace lib::midi::ble
         virtual bool     write(Packet& packet) = 0;
         virtual bool     read(Packet& packet)  = 0;
         virtual uint32_t time()                = 0;
+
+        /// Size of ATT header which is part of the MTU.
+        static constexpr size_t ATT_HEADER_SIZE = 3;
+
+        /// Minimum MTU allowed by BLE specification.
+        static constexpr size_t MIN_MTU = 23;
+
+        /// Reports ATT MTU negotiated for the current connection.
+        /// Default implementation reports the MTU which allows packets of MIDI_BLE_MAX_PACKET_SIZE bytes.
+        virtual size_t mtu()
+        {
+            return MIDI_BLE_MAX_PACKET_SIZE + ATT_HEADER_SIZE;
+        }
+
+        /// Blocks until new data is received or until the timeout passes, for instance by
+        /// taking semaphore given from receive interrupt, or with poll() on a file descriptor.
+        /// Default implementation doesn't wait, so the data has to be polled with read().
+        /// param timeout [in,out]    Maximum time to wait, in milliseconds. Should be decreased by
+        ///                           the time spent waiting, so that the caller can keep an overall deadline.
+        /// returns: True if data may be available, false on timeout or if waiting isn't supported.
+        virtual bool wait(uint32_t&)
+        {
+            return false;
+        }
     };
 }    // namespace lib::midi::ble
\ No newline at end of file
@@ -0,0 +1,72 @@
+/*
+    Copyright 2022 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "common.h"
+#include "lib/midi/ring.h"
+
+/// Size of the receive ring buffer used by BufferedHwa, must be a power of two.
+#ifndef MIDI_SERIAL_RX_BUFFER_SIZE
+#define MIDI_SERIAL_RX_BUFFER_SIZE 128
+#endif
+
+/// Size of the transmit ring buffer used by BufferedHwa, must be a power of two.
+#ifndef MIDI_SERIAL_TX_BUFFER_SIZE
+#define MIDI_SERIAL_TX_BUFFER_SIZE 128
+#endif
+
+/// Amount of consecutive attempts to queue data into full transmit buffer of BufferedHwa
+/// after which the write fails, for instance when the transmitter has stalled.
+#ifndef MIDI_SERIAL_TX_RETRIES
+#define MIDI_SERIAL_TX_RETRIES 100000
+#endif
+
+namespace lib::midi::serial
+{
+    /// Hwa backed by lock-free receive and transmit ring buffers.
+    /// Interrupt routine or DMA fills the receive buffer and drains the transmit buffer,
+    /// while the transport only copies blocks of data from and to the buffers.
+    /// Receive interrupt only needs to call rxBuffer().push() for every received byte.
+    /// Whenever new data is queued for transmission, startTransmission() is called so
+    /// that the implementation can enable TX interrupt or start DMA transfer from
+    /// txBuffer().readSpan() if the transmission isn't already running.
+    class BufferedHwa : public Hwa
+    {
+        public:
+        using RxBuffer = Ring<MIDI_SERIAL_RX_BUFFER_SIZE>;
+        using TxBuffer = Ring<MIDI_SERIAL_TX_BUFFER_SIZE>;
+
+        bool      write(Packet& packet) override;
+        bool      read(Packet& packet) override;
+        bool      write(const uint8_t* data, size_t size) override;
+        size_t    read(uint8_t* data, size_t size) override;
+        RxBuffer& rxBuffer();
+        TxBuffer& txBuffer();
+
+        protected:
+        virtual void startTransmission() = 0;
+
+        private:
+        RxBuffer _rxBuffer;
+        TxBuffer _txBuffer;
+    };
+}    // namespace lib::midi::serial
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <inttypes.h>
+#include <stddef.h>
 
 namespace lib::midi::serial
 {
@@ -16,5 +17,49 @@ namespace lib::midi::serial
         virtual bool deInit()            = 0;
         virtual bool write(Packet& data) = 0;
         virtual bool read(Packet& data)  = 0;
+
+        /// Writes block of data at once, for instance by starting DMA transfer.
+        /// Default implementation writes the data byte by byte.
+        virtual bool write(const uint8_t* data, size_t size)
+        {
+            for (size_t i = 0; i < size; i++)
+            {
+                Packet packet = { data[i] };
+
+                if (!write(packet))
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        /// Reads up to the specified amount of bytes at once, for instance from DMA buffer.
+        /// Default implementation reads the data byte by byte.
+        /// returns: Amount of read bytes.
+        virtual size_t read(uint8_t* data, size_t size)
+        {
+            size_t count = 0;
+            Packet packet;
+
+            while ((count < size) && read(packet))
+            {
+                data[count++] = packet.data;
+            }
+
+            return count;
+        }
+
+        /// Blocks until new data is received or until the timeout passes, for instance by
+        /// taking semaphore given from receive interrupt, or with poll() on a file descriptor.
+        /// Default implementation doesn't wait, so the data has to be polled with read().
+        /// param timeout [in,out]    Maximum time to wait, in milliseconds. Should be decreased by
+        ///                           the time spent waiting, so that the caller can keep an overall deadline.
+        /// returns: True if data may be available, false on timeout or if waiting isn't supported.
+        virtual bool wait(uint32_t&)
+        {
+            return false;
+        }
     };
 }    // namespace lib::midi::serial
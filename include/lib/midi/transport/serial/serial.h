@@ -26,34 +26,77 @@
 
 namespace lib::midi::serial
 {
-    class Serial : public Base
+    class Transport final : public lib::midi::Transport
     {
         public:
-        Serial(Hwa& hwa)
-            : Base(_transport)
-            , _transport(*this)
-            , _hwa(hwa)
+        Transport(Hwa& hwa)
+            : _hwa(hwa)
         {}
 
+        bool   init() override;
+        bool   deInit() override;
+        bool   beginTransmission(messageType_t type) override;
+        bool   write(uint8_t data) override;
+        bool   write(const uint8_t* data, size_t size) override;
+        bool   endTransmission() override;
+        bool   read(uint8_t& data) override;
+        size_t read(uint8_t* data, size_t size) override;
+        bool   wait(uint32_t& timeout) override;
+
+#if MIDI_STATS
+        TransportStats stats();
+#endif
+
+        private:
+        /// Amount of bytes transferred from and to Hwa at once.
+        static constexpr size_t CHUNK_SIZE = 16;
+
+        Hwa&                            _hwa;
+        std::array<uint8_t, CHUNK_SIZE> _rxBuffer = {};
+        size_t                          _rxIndex  = 0;
+        size_t                          _rxCount  = 0;
+        std::array<uint8_t, CHUNK_SIZE> _txBuffer = {};
+        size_t                          _txCount  = 0;
+
+#if MIDI_STATS
+        TransportStats _stats = {};
+#endif
+
+        bool writeStaged();
+    };
+
+    class Serial : public BasicMidi<Transport>
+    {
+        public:
+        Serial(Hwa& hwa)
+            : BasicMidi(_transport)
+            , _transport(hwa)
+        {
+            useRecursiveParsing(true);
+        }
+
         private:
-        class Transport : public lib::midi::Transport
+        Transport _transport;
+    };
+
+    /// Same as Serial, but derived from Base so that it can be passed to code which takes lib::midi::Base&.
+    /// Calls to the transport are dispatched through vtable.
+    class SerialBase : public Base
+    {
+        public:
+        SerialBase(Hwa& hwa)
+            : Base(_transport)
+            , _transport(hwa)
         {
-            public:
-            Transport(Serial& serial)
-                : _serial(serial)
-            {}
-
-            bool init() override;
-            bool deInit() override;
-            bool beginTransmission(messageType_t type) override;
-            bool write(uint8_t data) override;
-            bool endTransmission() override;
-            bool read(uint8_t& data) override;
-
-            private:
-            Serial& _serial;
-        } _transport;
-
-        Hwa& _hwa;
+            useRecursiveParsing(true);
+        }
+
+        private:
+        Transport _transport;
     };
-}    // namespace lib::midi::serial
\ No newline at end of file
+}    // namespace lib::midi::serial
+
+namespace lib::midi
+{
+    extern template class BasicMidi<serial::Transport>;
+}    // namespace lib::midi
\ No newline at end of file
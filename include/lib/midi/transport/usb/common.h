@@ -22,8 +22,33 @@
 #pragma once
 
 #include <array>
+#include <stddef.h>
 #include <inttypes.h>
 
+/// Amount of outgoing packets collected before they are passed to Hwa at once.
+/// Packets are written as soon as the buffer is full or when Usb::flush() is called.
+/// Set to the endpoint size divided by 4 (16 for full-speed, 128 for high-speed bulk endpoint)
+/// to write entire transfer at once. When set to 1, every message is written immediately.
+#ifndef MIDI_USB_TX_PACKETS
+#define MIDI_USB_TX_PACKETS 1
+#endif
+
+/// Maximum amount of packets retrieved from Hwa at once.
+#ifndef MIDI_USB_RX_PACKETS
+#define MIDI_USB_RX_PACKETS 16
+#endif
+
+/// Amount of virtual cables handled by usb::Multiplexer.
+#ifndef MIDI_USB_CABLES
+#define MIDI_USB_CABLES 16
+#endif
+
+/// Amount of outgoing packets from all the cables collected by usb::Multiplexer
+/// before they are passed to Hwa at once.
+#ifndef MIDI_USB_MUX_TX_PACKETS
+#define MIDI_USB_MUX_TX_PACKETS 16
+#endif
+
 namespace lib::midi::usb
 {
     struct Packet
@@ -46,5 +71,56 @@ namespace lib::midi::usb
         virtual bool deInit()              = 0;
         virtual bool write(Packet& packet) = 0;
         virtual bool read(Packet& packet)  = 0;
+
+        /// Writes several packets at once, for instance as a single USB transfer.
+        /// Default implementation writes the packets one by one.
+        virtual bool write(const Packet* packets, size_t count)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                Packet packet = packets[i];
+
+                if (!write(packet))
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        /// Reads up to the specified amount of packets at once, for instance entire received USB transfer.
+        /// Default implementation reads the packets one by one.
+        /// returns: Amount of read packets.
+        virtual size_t read(Packet* packets, size_t count)
+        {
+            size_t index = 0;
+
+            while ((index < count) && read(packets[index]))
+            {
+                index++;
+            }
+
+            return index;
+        }
+
+        /// Writes out packets which Hwa collects on its own before writing them to the endpoint.
+        /// Called whenever the transport is flushed. Default implementation has nothing to write.
+        /// returns: False if Hwa fails to write the packets, true otherwise.
+        virtual bool flush()
+        {
+            return true;
+        }
+
+        /// Blocks until new data is received or until the timeout passes, for instance by
+        /// taking semaphore given from receive interrupt, or with poll() on a file descriptor.
+        /// Default implementation doesn't wait, so the data has to be polled with read().
+        /// param timeout [in,out]    Maximum time to wait, in milliseconds. Should be decreased by
+        ///                           the time spent waiting, so that the caller can keep an overall deadline.
+        /// returns: True if data may be available, false on timeout or if waiting isn't supported.
+        virtual bool wait(uint32_t&)
+        {
+            return false;
+        }
     };
 }    // namespace lib::midi::usb
\ No newline at end of file
@@ -0,0 +1,97 @@
+/*
+    Copyright 2022 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include "common.h"
+#include "lib/midi/common.h"
+
+namespace lib::midi::usb
+{
+    /// Shares single USB MIDI endpoint between several virtual cables.
+    /// Every cable is a Hwa interface on its own, to be used by a separate Usb instance
+    /// so that each cable gets its own parser state. Endpoint is read only once for all
+    /// the cables: received packets are routed to the cable specified in the packet header.
+    /// Outgoing packets from all the cables are collected into shared buffer which is
+    /// written to the endpoint when full, when flush() is called or when any of the cables is flushed.
+    /// Packets for cables which aren't initialized are dropped. When the queue of a cable
+    /// is full, reading of the endpoint stops until that cable is read, so that no data is lost
+    /// and the endpoint can signal the host to hold back: all the initialized cables must be read.
+    class Multiplexer
+    {
+        public:
+        class Cable : public Hwa
+        {
+            public:
+            bool   init() override;
+            bool   deInit() override;
+            bool   write(Packet& packet) override;
+            bool   read(Packet& packet) override;
+            bool   write(const Packet* packets, size_t count) override;
+            size_t read(Packet* packets, size_t count) override;
+            bool   flush() override;
+            bool   wait(uint32_t& timeout) override;
+
+            private:
+            friend class Multiplexer;
+
+            Multiplexer*                            _multiplexer = nullptr;
+            uint8_t                                 _index       = 0;
+            std::array<Packet, MIDI_USB_RX_PACKETS> _rxPackets   = {};
+            size_t                                  _rxHead      = 0;
+            size_t                                  _rxCount     = 0;
+            bool                                    _active      = false;
+
+            bool push(const Packet& packet);
+        };
+
+        Multiplexer(Hwa& hwa);
+
+        Cable& cable(uint8_t index);
+        bool   flush();
+
+#if MIDI_STATS
+        uint32_t dropped();
+#endif
+
+        private:
+        Hwa&                                        _hwa;
+        std::array<Cable, MIDI_USB_CABLES>          _cables        = {};
+        size_t                                      _initCount     = 0;
+        std::array<Packet, MIDI_USB_RX_PACKETS>     _rxPackets     = {};
+        size_t                                      _rxPacketIndex = 0;
+        size_t                                      _rxPacketCount = 0;
+        std::array<Packet, MIDI_USB_MUX_TX_PACKETS> _txPackets     = {};
+        size_t                                      _txPacketCount = 0;
+
+#if MIDI_STATS
+        uint32_t _dropped = 0;
+#endif
+
+        bool init();
+        bool deInit();
+        bool write(uint8_t cable, const Packet* packets, size_t count);
+        void receive();
+        bool pending();
+        bool wait(uint32_t& timeout);
+    };
+}    // namespace lib::midi::usb
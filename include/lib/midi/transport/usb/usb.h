@@ -26,60 +26,108 @@
 
 namespace lib::midi::usb
 {
-    class Usb : public Base
+    class Transport final : public lib::midi::Transport
     {
         public:
-        Usb(Hwa& hwa, uint8_t cin = 0)
-            : Base(_transport)
-            , _transport(*this, cin)
-            , _hwa(hwa)
+        Transport(Hwa& hwa, uint8_t cin)
+            : _hwa(hwa)
+            , CIN(cin)
         {}
 
+        bool         init() override;
+        bool         deInit() override;
+        bool         beginTransmission(messageType_t type) override;
+        bool         write(uint8_t data) override;
+        bool         write(const uint8_t* data, size_t size) override;
+        bool         endTransmission() override;
+        bool         read(uint8_t& data) override;
+        size_t       read(uint8_t* data, size_t size) override;
+        readResult_t readMessage(Message& message) override;
+        bool         flush() override;
+        bool         byteStream() override;
+        bool         wait(uint32_t& timeout) override;
+
+#if MIDI_STATS
+        TransportStats stats();
+#endif
+
         private:
-        class Transport : public lib::midi::Transport
+        /// Enumeration holding USB-specific events for SysEx/System Common messages.
+        enum class systemEvent_t : uint8_t
+        {
+            SYS_COMMON1BYTE  = 0x50,
+            SYS_COMMON2BYTE  = 0x20,
+            SYS_COMMON3BYTE  = 0x30,
+            SINGLE_BYTE      = 0xF0,
+            SYS_EX_START     = 0x40,
+            SYS_EX_STOP1BYTE = 0x50,
+            SYS_EX_STOP2BYTE = 0x60,
+            SYS_EX_STOP3BYTE = 0x70
+        };
+
+        Hwa&                                    _hwa;
+        const uint8_t                           CIN;
+        uint8_t                                 _rxIndex       = 0;
+        uint8_t                                 _rxCount       = 0;
+        uint8_t                                 _rxBuffer[3]   = {};
+        std::array<Packet, MIDI_USB_RX_PACKETS> _rxPackets     = {};
+        size_t                                  _rxPacketIndex = 0;
+        size_t                                  _rxPacketCount = 0;
+        Packet                                  _txBuffer      = {};
+        uint8_t                                 _txIndex       = 0;
+        std::array<Packet, MIDI_USB_TX_PACKETS> _txPackets     = {};
+        size_t                                  _txPacketCount = 0;
+        messageType_t                           _activeType    = messageType_t::INVALID;
+
+#if MIDI_STATS
+        TransportStats _stats = {};
+#endif
+
+        const Packet* nextPacket();
+        bool          receive();
+        bool          load(const Packet& packet);
+        bool          writePacket(Packet& packet);
+        bool          writeStaged();
+
+        /// Used to construct a USB MIDI header from a given MIDI event and a virtual MIDI cable index.
+        static constexpr uint8_t usbMIDIHeader(uint8_t virtualcable, uint8_t event)
         {
-            public:
-            Transport(Usb& usb, uint8_t cin)
-                : _usb(usb)
-                , CIN(cin)
-            {}
-
-            bool init() override;
-            bool deInit() override;
-            bool beginTransmission(messageType_t type) override;
-            bool write(uint8_t data) override;
-            bool endTransmission() override;
-            bool read(uint8_t& data) override;
-
-            private:
-            /// Enumeration holding USB-specific events for SysEx/System Common messages.
-            enum class systemEvent_t : uint8_t
-            {
-                SYS_COMMON1BYTE  = 0x50,
-                SYS_COMMON2BYTE  = 0x20,
-                SYS_COMMON3BYTE  = 0x30,
-                SINGLE_BYTE      = 0xF0,
-                SYS_EX_START     = 0x40,
-                SYS_EX_STOP1BYTE = 0x50,
-                SYS_EX_STOP2BYTE = 0x60,
-                SYS_EX_STOP3BYTE = 0x70
-            };
-
-            Usb&          _usb;
-            const uint8_t CIN;
-            uint8_t       _rxIndex     = 0;
-            uint8_t       _rxBuffer[3] = {};
-            Packet        _txBuffer    = {};
-            uint8_t       _txIndex     = 0;
-            messageType_t _activeType  = messageType_t::INVALID;
-
-            /// Used to construct a USB MIDI header from a given MIDI event and a virtual MIDI cable index.
-            static constexpr uint8_t usbMIDIHeader(uint8_t virtualcable, uint8_t event)
-            {
-                return ((virtualcable << 4) | (event >> 4));
-            }
-        } _transport;
-
-        Hwa& _hwa;
+            return ((virtualcable << 4) | (event >> 4));
+        }
+    };
+
+    class Usb : public BasicMidi<Transport>
+    {
+        public:
+        Usb(Hwa& hwa, uint8_t cin = 0)
+            : BasicMidi(_transport)
+            , _transport(hwa, cin)
+        {
+            useRecursiveParsing(true);
+        }
+
+        private:
+        Transport _transport;
+    };
+
+    /// Same as Usb, but derived from Base so that it can be passed to code which takes lib::midi::Base&.
+    /// Calls to the transport are dispatched through vtable.
+    class UsbBase : public Base
+    {
+        public:
+        UsbBase(Hwa& hwa, uint8_t cin = 0)
+            : Base(_transport)
+            , _transport(hwa, cin)
+        {
+            useRecursiveParsing(true);
+        }
+
+        private:
+        Transport _transport;
     };
 }    // namespace lib::midi::usb
+
+namespace lib::midi
+{
+    extern template class BasicMidi<usb::Transport>;
+}    // namespace lib::midi
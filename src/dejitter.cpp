@@ -0,0 +1,88 @@
+/*
+    Copyright 2022 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "lib/midi/dejitter.h"
+
+using namespace lib::midi;
+
+/// Stores received message until it's due.
+/// Messages are expected to be pushed in the order in which they were sent.
+/// param message [in]     Received message.
+/// param timestamp [in]   Time at which the message was sent, in the same units as time passed to pop().
+/// returns: False if the buffer is full, true otherwise.
+bool Dejitter::push(const Message& message, uint32_t timestamp)
+{
+    if (_count == _buffer.size())
+    {
+        return false;
+    }
+
+    const size_t INDEX = (_head + _count) % _buffer.size();
+
+    _buffer[INDEX]     = message;
+    _timestamps[INDEX] = timestamp;
+    _count++;
+
+    return true;
+}
+
+/// Retrieves the oldest stored message once its scheduled time is reached.
+/// Messages which arrived later than their scheduled time are released immediately.
+/// param time [in]        Current time.
+/// param message [in,out] Released message, modified only if true is returned.
+/// returns: True if a message has been released, false otherwise.
+bool Dejitter::pop(uint32_t time, Message& message)
+{
+    if (!_count)
+    {
+        return false;
+    }
+
+    if (static_cast<int32_t>(time - (_timestamps[_head] + _delay)) < 0)
+    {
+        return false;
+    }
+
+    message = _buffer[_head];
+    _head   = (_head + 1) % _buffer.size();
+    _count--;
+
+    return true;
+}
+
+/// Retrieves the amount of messages waiting to be released.
+size_t Dejitter::size()
+{
+    return _count;
+}
+
+/// Discards all stored messages.
+void Dejitter::clear()
+{
+    _head  = 0;
+    _count = 0;
+}
+
+/// Sets the time, in units of message timestamps, for which every message is held.
+void Dejitter::setDelay(uint32_t delay)
+{
+    _delay = delay;
+}
@@ -21,11 +21,83 @@
 */
 
 #include "lib/midi/midi.h"
+#include "lib/midi/transport/ble/ble.h"
+#include "lib/midi/transport/serial/serial.h"
+#include "lib/midi/transport/usb/usb.h"
+#include <algorithm>
 #include <cstddef>
 
 using namespace lib::midi;
 
-bool Base::init()
+namespace
+{
+    /// Bits describing every possible byte received by the parser.
+    constexpr uint8_t STATUS_LENGTH_MASK    = 0x03;    ///< Length of the message, including the status byte.
+    constexpr uint8_t STATUS_RUNNING_STATUS = 0x04;    ///< Status byte can be used as running status.
+    constexpr uint8_t STATUS_REAL_TIME      = 0x08;    ///< Single byte message which can be interleaved anywhere.
+    constexpr uint8_t STATUS_SYS_EX_START   = 0x10;
+    constexpr uint8_t STATUS_SYS_EX_END     = 0x20;
+
+    constexpr uint8_t statusInfo(uint8_t status)
+    {
+        switch (TYPE_FROM_STATUS_BYTE(status))
+        {
+        case messageType_t::PROGRAM_CHANGE:
+        case messageType_t::AFTER_TOUCH_CHANNEL:
+            return 2 | STATUS_RUNNING_STATUS;
+
+        case messageType_t::NOTE_ON:
+        case messageType_t::NOTE_OFF:
+        case messageType_t::CONTROL_CHANGE:
+        case messageType_t::PITCH_BEND:
+        case messageType_t::AFTER_TOUCH_POLY:
+            return 3 | STATUS_RUNNING_STATUS;
+
+        case messageType_t::SYS_COMMON_TUNE_REQUEST:
+            return 1;
+
+        case messageType_t::SYS_COMMON_TIME_CODE_QUARTER_FRAME:
+        case messageType_t::SYS_COMMON_SONG_SELECT:
+            return 2;
+
+        case messageType_t::SYS_COMMON_SONG_POSITION:
+            return 3;
+
+        case messageType_t::SYS_REAL_TIME_CLOCK:
+        case messageType_t::SYS_REAL_TIME_START:
+        case messageType_t::SYS_REAL_TIME_CONTINUE:
+        case messageType_t::SYS_REAL_TIME_STOP:
+        case messageType_t::SYS_REAL_TIME_ACTIVE_SENSING:
+        case messageType_t::SYS_REAL_TIME_SYSTEM_RESET:
+            return 1 | STATUS_REAL_TIME;
+
+        case messageType_t::SYS_EX:
+            return STATUS_SYS_EX_START;
+
+        default:
+            return (status == 0xF7) ? STATUS_SYS_EX_END : 0;
+        }
+    }
+
+    constexpr std::array<uint8_t, 256> makeStatusTable()
+    {
+        std::array<uint8_t, 256> table = {};
+
+        for (size_t i = 0x80; i < table.size(); i++)
+        {
+            table[i] = statusInfo(i);
+        }
+
+        return table;
+    }
+
+    /// Lookup table used by the parser, indexed with received byte.
+    /// Data bytes and undefined status bytes are set to 0.
+    constexpr std::array<uint8_t, 256> STATUS_TABLE = makeStatusTable();
+}    // namespace
+
+template<typename TransportT>
+bool BasicMidi<TransportT>::init()
 {
     if (_initialized)
     {
@@ -34,6 +106,10 @@ bool Base::init()
 
     reset();
 
+    // state of the receiver is unknown until the status byte is sent again
+    _transport.setRunningStatus(static_cast<uint8_t>(messageType_t::INVALID));
+    _runningStatusBytes = 0;
+
     if (_transport.init())
     {
         _initialized = true;
@@ -43,7 +119,8 @@ bool Base::init()
     return false;
 }
 
-bool Base::deInit()
+template<typename TransportT>
+bool BasicMidi<TransportT>::deInit()
 {
     if (!_initialized)
     {
@@ -51,30 +128,41 @@ bool Base::deInit()
     }
 
     reset();
-    _initialized = false;
+    _transport.setRunningStatus(static_cast<uint8_t>(messageType_t::INVALID));
+    _runningStatusBytes = 0;
+    _initialized        = false;
+
     return _transport.deInit();
 }
 
-bool Base::initialized()
+template<typename TransportT>
+bool BasicMidi<TransportT>::initialized()
 {
     return _initialized;
 }
 
-void Base::reset()
+template<typename TransportT>
+void BasicMidi<TransportT>::reset()
 {
+    abortSysExStream();
+
     _mRunningStatusRX             = 0;
     _pendingMessageExpectedLength = 0;
     _pendingMessageIndex          = 0;
 }
 
-Transport& Base::transport()
+template<typename TransportT>
+TransportT& BasicMidi<TransportT>::transport()
 {
     return _transport;
 }
 
 /// Generate and send a MIDI message from the values given.
 /// Use this only if you need to send raw data.
-bool Base::send(messageType_t inType, uint8_t inData1, uint8_t inData2, uint8_t inChannel)
+/// While scheduled SysEx message is being sent in parts by tick(), only Real Time
+/// messages can be sent: anything else would end the SysEx message at the receiver.
+template<typename TransportT>
+bool BasicMidi<TransportT>::send(messageType_t inType, uint8_t inData1, uint8_t inData2, uint8_t inChannel)
 {
     bool channelValid = true;
 
@@ -86,16 +174,16 @@ bool Base::send(messageType_t inType, uint8_t inData1, uint8_t inData2, uint8_t
 
     if (!channelValid || (inType < messageType_t::NOTE_OFF))
     {
-        if (_useRunningStatus)
-        {
-            _mRunningStatusTX = static_cast<uint8_t>(messageType_t::INVALID);
-        }
-
         return false;    // don't send anything
     }
 
     if (inType <= messageType_t::PITCH_BEND)
     {
+        if (_sysExRemaining)
+        {
+            return false;    // scheduled SysEx is in progress
+        }
+
         // channel messages
         // protection: remove MSBs on data
         inData1 &= 0x7F;
@@ -103,45 +191,36 @@ bool Base::send(messageType_t inType, uint8_t inData1, uint8_t inData2, uint8_t
 
         const uint8_t IN_STATUS = status(inType, inChannel);
 
-        if (_transport.beginTransmission(inType))
+        if (beginTransmission(inType))
         {
-            if (_useRunningStatus)
-            {
-                if (_mRunningStatusTX != IN_STATUS)
-                {
-                    // new message, memorize and send header
-                    _mRunningStatusTX = IN_STATUS;
+            bool result = true;
 
-                    if (!_transport.write(_mRunningStatusTX))
-                    {
-                        return false;
-                    }
-                }
+            if (omitStatus(IN_STATUS))
+            {
+                MIDI_STAT(_stats.runningStatusOut++);
             }
             else
             {
-                // don't care about running status, send the status byte
-                if (!_transport.write(IN_STATUS))
-                {
-                    return false;
-                }
+                result              = write(IN_STATUS);
+                _runningStatusBytes = 0;
             }
 
             // send data
-            if (!_transport.write(inData1))
-            {
-                return false;
-            }
+            result = result && write(inData1);
+            _runningStatusBytes++;
 
             if ((inType != messageType_t::PROGRAM_CHANGE) && (inType != messageType_t::AFTER_TOUCH_CHANNEL))
             {
-                if (!_transport.write(inData2))
-                {
-                    return false;
-                }
+                result = result && write(inData2);
+                _runningStatusBytes++;
             }
 
-            return _transport.endTransmission();
+            result = result && endTransmission(inType);
+
+            // after failure it isn't known which bytes have reached the receiver
+            _transport.setRunningStatus(result ? IN_STATUS : static_cast<uint8_t>(messageType_t::INVALID));
+
+            return result;
         }
     }
     else if ((inType >= messageType_t::SYS_COMMON_TUNE_REQUEST) && (inType <= messageType_t::SYS_REAL_TIME_SYSTEM_RESET))
@@ -153,35 +232,104 @@ bool Base::send(messageType_t inType, uint8_t inData1, uint8_t inData2, uint8_t
     return false;
 }
 
+/// Sends decoded message, for instance the one retrieved with message() or pop().
+/// SysEx messages can't be sent this way since the payload isn't part of the message.
+/// Only Real Time messages are sent while scheduled SysEx message is being sent in parts.
+/// param message [in]    Message to send.
+/// returns: True on success, false otherwise.
+template<typename TransportT>
+bool BasicMidi<TransportT>::send(const Message& message)
+{
+    if (IS_CHANNEL_MESSAGE(message.type))
+    {
+        return send(message.type, message.data1, message.data2, message.channel);
+    }
+
+    if (IS_SYSTEM_REAL_TIME(message.type))
+    {
+        return sendRealTime(message.type);
+    }
+
+    switch (message.type)
+    {
+    case messageType_t::SYS_COMMON_SONG_POSITION:
+        return sendSongPosition(message.data1 | (message.data2 << 7));
+
+    case messageType_t::SYS_COMMON_TIME_CODE_QUARTER_FRAME:
+    case messageType_t::SYS_COMMON_SONG_SELECT:
+    case messageType_t::SYS_COMMON_TUNE_REQUEST:
+        return sendCommon(message.type, message.data1);
+
+    default:
+        return false;
+    }
+}
+
+/// Sends out messages buffered by transport interface and by registered thru interfaces.
+/// Needs to be called periodically if any of the interfaces doesn't send messages immediately.
+/// returns: True if all the interfaces have sent their data, false otherwise.
+template<typename TransportT>
+bool BasicMidi<TransportT>::flush()
+{
+    bool result = _transport.flush();
+
+    for (size_t i = 0; i < _thruInterface.size(); i++)
+    {
+        if (_thruInterface.at(i) != nullptr)
+        {
+            result &= _thruInterface.at(i)->flush();
+        }
+    }
+
+    return result;
+}
+
 /// Send a Note On message.
 /// param inNoteNumber [in]    Pitch value in the MIDI format (0 to 127).
 /// param inVelocity [in]      Note attack velocity (0 to 127).
 /// param inChannel [in]       The channel on which the message will be sent (1 to 16).
-bool Base::sendNoteOn(uint8_t inNoteNumber, uint8_t inVelocity, uint8_t inChannel)
+template<typename TransportT>
+bool BasicMidi<TransportT>::sendNoteOn(uint8_t inNoteNumber, uint8_t inVelocity, uint8_t inChannel)
 {
     return send(messageType_t::NOTE_ON, inNoteNumber, inVelocity, inChannel);
 }
 
 /// Send a Note Off message.
-/// If note off mode is set to noteOffType_t::standardNoteOff, Note Off message will be sent.
-/// If mode is set to noteOffType_noteOnZeroVel, Note On will be sent will velocity 0.
+/// If note off mode is set to noteOffType_t::STANDARD_NOTE_OFF, Note Off message will be sent.
+/// If mode is set to noteOffType_t::NOTE_ON_ZERO_VEL, Note On will be sent with velocity 0.
+/// If mode is set to noteOffType_t::KEEP_RUNNING_STATUS, Note On with velocity 0 is sent only
+/// when the status byte can be omitted that way: release velocity is lost in that case.
 /// param inNoteNumber [in]    Pitch value in the MIDI format (0 to 127).
 /// param inVelocity [in]      Release velocity (0 to 127).
 /// param inChannel [in]       The channel on which the message will be sent (1 to 16).
-bool Base::sendNoteOff(uint8_t inNoteNumber, uint8_t inVelocity, uint8_t inChannel)
+template<typename TransportT>
+bool BasicMidi<TransportT>::sendNoteOff(uint8_t inNoteNumber, uint8_t inVelocity, uint8_t inChannel)
 {
-    if (_noteOffMode == noteOffType_t::STANDARD_NOTE_OFF)
+    switch (_noteOffMode)
     {
+    case noteOffType_t::STANDARD_NOTE_OFF:
         return send(messageType_t::NOTE_OFF, inNoteNumber, inVelocity, inChannel);
+
+    case noteOffType_t::KEEP_RUNNING_STATUS:
+    {
+        if (!omitStatus(status(messageType_t::NOTE_ON, inChannel)))
+        {
+            return send(messageType_t::NOTE_OFF, inNoteNumber, inVelocity, inChannel);
+        }
+
+        return send(messageType_t::NOTE_ON, inNoteNumber, 0, inChannel);
     }
 
-    return send(messageType_t::NOTE_ON, inNoteNumber, inVelocity, inChannel);
+    default:
+        return send(messageType_t::NOTE_ON, inNoteNumber, 0, inChannel);
+    }
 }
 
 /// Send a Program Change message.
 /// param inProgramNumber [in]     The program to select (0 to 127).
 /// param inChannel [in]           The channel on which the message will be sent (1 to 16).
-bool Base::sendProgramChange(uint8_t inProgramNumber, uint8_t inChannel)
+template<typename TransportT>
+bool BasicMidi<TransportT>::sendProgramChange(uint8_t inProgramNumber, uint8_t inChannel)
 {
     return send(messageType_t::PROGRAM_CHANGE, inProgramNumber, 0, inChannel);
 }
@@ -190,7 +338,8 @@ bool Base::sendProgramChange(uint8_t inProgramNumber, uint8_t inChannel)
 /// param inControlNumber [in]     The controller number (0 to 127).
 /// param inControlValue [in]      The value for the specified controller (0 to 127).
 /// param inChannel [in]           The channel on which the message will be sent (1 to 16).
-bool Base::sendControlChange(uint8_t inControlNumber, uint8_t inControlValue, uint8_t inChannel)
+template<typename TransportT>
+bool BasicMidi<TransportT>::sendControlChange(uint8_t inControlNumber, uint8_t inControlValue, uint8_t inChannel)
 {
     return send(messageType_t::CONTROL_CHANGE, inControlNumber, inControlValue, inChannel);
 }
@@ -199,7 +348,8 @@ bool Base::sendControlChange(uint8_t inControlNumber, uint8_t inControlValue, ui
 /// param inPressure [in]    The amount of AfterTouch to apply (0 to 127).
 /// param inChannel [in]     The channel on which the message will be sent (1 to 16).
 /// param inNoteNumber [in]  The note to apply AfterTouch to (0 to 127).
-bool Base::sendAfterTouch(uint8_t inPressure, uint8_t inChannel, uint8_t inNoteNumber)
+template<typename TransportT>
+bool BasicMidi<TransportT>::sendAfterTouch(uint8_t inPressure, uint8_t inChannel, uint8_t inNoteNumber)
 {
     return send(messageType_t::AFTER_TOUCH_POLY, inNoteNumber, inPressure, inChannel);
 }
@@ -207,7 +357,8 @@ bool Base::sendAfterTouch(uint8_t inPressure, uint8_t inChannel, uint8_t inNoteN
 /// Send a Monophonic AfterTouch message (applies to all notes).
 /// param inPressure [in]    The amount of AfterTouch to apply (0 to 127).
 /// param inChannel [in]     The channel on which the message will be sent (1 to 16).
-bool Base::sendAfterTouch(uint8_t inPressure, uint8_t inChannel)
+template<typename TransportT>
+bool BasicMidi<TransportT>::sendAfterTouch(uint8_t inPressure, uint8_t inChannel)
 {
     return send(messageType_t::AFTER_TOUCH_CHANNEL, inPressure, 0, inChannel);
 }
@@ -215,7 +366,8 @@ bool Base::sendAfterTouch(uint8_t inPressure, uint8_t inChannel)
 /// Send a Pitch Bend message using a signed integer value.
 /// param inPitchValue [in]  The amount of bend to send (0-16383).
 /// param inChannel [in]     The channel on which the message will be sent (1 to 16).
-bool Base::sendPitchBend(uint16_t inPitchValue, uint8_t inChannel)
+template<typename TransportT>
+bool BasicMidi<TransportT>::sendPitchBend(uint16_t inPitchValue, uint8_t inChannel)
 {
     auto split = Split14Bit(inPitchValue & 0x3FFF);
 
@@ -227,43 +379,71 @@ bool Base::sendPitchBend(uint16_t inPitchValue, uint8_t inChannel)
 /// param inArray [in]                     The byte array containing the data to send
 /// param inArrayContainsBoundaries [in]   When set to 'true', 0xF0 & 0xF7 bytes (start & stop SysEx)
 ///                                        will not be sent and therefore must be included in the array.
-bool Base::sendSysEx(uint16_t inLength, const uint8_t* inArray, bool inArrayContainsBoundaries)
+template<typename TransportT>
+bool BasicMidi<TransportT>::sendSysEx(uint16_t inLength, const uint8_t* inArray, bool inArrayContainsBoundaries)
+{
+    const Segment SEGMENT = { inArray, inLength };
+
+    return sendSysEx(&SEGMENT, 1, inArrayContainsBoundaries);
+}
+
+/// Send a System Exclusive message stored in several separate buffers.
+/// Buffers are passed to the transport interface as they are, without being copied.
+/// Real Time messages passed to injectRealTime() while the message is being sent are
+/// inserted after every slice of setSysExChunkSize() bytes, or after every buffer if not set.
+/// param segments [in]                    Array of buffers containing the data to send, in order.
+/// param count [in]                       Amount of buffers in the array.
+/// param inArrayContainsBoundaries [in]   When set to 'true', 0xF0 & 0xF7 bytes (start & stop SysEx)
+///                                        will not be sent and therefore must be included in the buffers.
+/// returns: False on failure, or if scheduled SysEx message is being sent in parts by tick().
+template<typename TransportT>
+bool BasicMidi<TransportT>::sendSysEx(const Segment* segments, size_t count, bool inArrayContainsBoundaries)
 {
-    if (_transport.beginTransmission(messageType_t::SYS_EX))
+    if (_sysExRemaining)
+    {
+        return false;
+    }
+
+    if (beginTransmission(messageType_t::SYS_EX))
     {
+        // SysEx cancels running status on the receiving side
+        _transport.setRunningStatus(static_cast<uint8_t>(messageType_t::INVALID));
+
         if (!inArrayContainsBoundaries)
         {
-            if (!_transport.write(0xF0))
+            if (!write(0xF0))
             {
                 return false;
             }
         }
 
-        for (uint16_t i = 0; i < inLength; ++i)
+        for (size_t i = 0; i < count; i++)
         {
-            if (!_transport.write(inArray[i]))
+            size_t offset = 0;
+
+            // Real Time messages injected meanwhile are sent between slices
+            while (offset < segments[i].size)
             {
-                return false;
+                const size_t SLICE = _sysExChunkSize ? std::min<size_t>(_sysExChunkSize, segments[i].size - offset) : segments[i].size;
+
+                if (!write(&segments[i].data[offset], SLICE) || !writePendingRealTime())
+                {
+                    return false;
+                }
+
+                offset += SLICE;
             }
         }
 
         if (!inArrayContainsBoundaries)
         {
-            if (!_transport.write(0xF7))
+            if (!write(0xF7))
             {
                 return false;
             }
         }
 
-        if (_transport.endTransmission())
-        {
-            if (_useRunningStatus)
-            {
-                _mRunningStatusTX = static_cast<uint8_t>(messageType_t::INVALID);
-            }
-
-            return true;
-        }
+        return endTransmission(messageType_t::SYS_EX);
     }
 
     return false;
@@ -271,7 +451,8 @@ bool Base::sendSysEx(uint16_t inLength, const uint8_t* inArray, bool inArrayCont
 
 /// Send a Tune Request message.
 /// When a MIDI unit receives this message, it should tune its oscillators (if equipped with any).
-bool Base::sendTuneRequest()
+template<typename TransportT>
+bool BasicMidi<TransportT>::sendTuneRequest()
 {
     return sendCommon(messageType_t::SYS_COMMON_TUNE_REQUEST);
 }
@@ -280,7 +461,8 @@ bool Base::sendTuneRequest()
 /// param inTypeNibble [in]    MTC type.
 /// param inValuesNibble [in]  MTC data.
 /// See MIDI Specification for more information.
-bool Base::sendTimeCodeQuarterFrame(uint8_t inTypeNibble, uint8_t inValuesNibble)
+template<typename TransportT>
+bool BasicMidi<TransportT>::sendTimeCodeQuarterFrame(uint8_t inTypeNibble, uint8_t inValuesNibble)
 {
     const uint8_t DATA = (((inTypeNibble & 0x07) << 4) | (inValuesNibble & 0x0F));
     return sendTimeCodeQuarterFrame(DATA);
@@ -289,21 +471,24 @@ bool Base::sendTimeCodeQuarterFrame(uint8_t inTypeNibble, uint8_t inValuesNibble
 /// Send a MIDI Time Code Quarter Frame.
 /// param inData [in]  If you want to encode directly the nibbles in your program,
 ///                     you can send the byte here.
-bool Base::sendTimeCodeQuarterFrame(uint8_t inData)
+template<typename TransportT>
+bool BasicMidi<TransportT>::sendTimeCodeQuarterFrame(uint8_t inData)
 {
     return sendCommon(messageType_t::SYS_COMMON_TIME_CODE_QUARTER_FRAME, inData);
 }
 
 /// Send a Song Position Pointer message.
 /// param inBeats [in]     The number of beats since the start of the song.
-bool Base::sendSongPosition(uint16_t inBeats)
+template<typename TransportT>
+bool BasicMidi<TransportT>::sendSongPosition(uint16_t inBeats)
 {
     return sendCommon(messageType_t::SYS_COMMON_SONG_POSITION, inBeats);
 }
 
 /// Send a Song Select message.
 /// param inSongNumber [in]    Song to select (0-127).
-bool Base::sendSongSelect(uint8_t inSongNumber)
+template<typename TransportT>
+bool BasicMidi<TransportT>::sendSongSelect(uint8_t inSongNumber)
 {
     return sendCommon(messageType_t::SYS_COMMON_SONG_SELECT, inSongNumber);
 }
@@ -315,8 +500,15 @@ bool Base::sendSongSelect(uint8_t inSongNumber)
 ///                     sysCommonSongSelect
 ///                     sysCommonTuneRequest
 /// inData1             The byte that goes with the common message, if any.
-bool Base::sendCommon(messageType_t inType, uint8_t inData1)
+///                     Song Position takes the whole 14-bit value.
+template<typename TransportT>
+bool BasicMidi<TransportT>::sendCommon(messageType_t inType, uint16_t inData1)
 {
+    if (_sysExRemaining)
+    {
+        return false;    // scheduled SysEx is in progress
+    }
+
     switch (inType)
     {
     case messageType_t::SYS_COMMON_TIME_CODE_QUARTER_FRAME:
@@ -329,9 +521,12 @@ bool Base::sendCommon(messageType_t inType, uint8_t inData1)
         return false;
     }
 
-    if (_transport.beginTransmission(inType))
+    if (beginTransmission(inType))
     {
-        if (!_transport.write(static_cast<uint8_t>(inType)))
+        // System Common message cancels running status on the receiving side
+        _transport.setRunningStatus(static_cast<uint8_t>(messageType_t::INVALID));
+
+        if (!write(static_cast<uint8_t>(inType)))
         {
             return false;
         }
@@ -340,7 +535,7 @@ bool Base::sendCommon(messageType_t inType, uint8_t inData1)
         {
         case messageType_t::SYS_COMMON_TIME_CODE_QUARTER_FRAME:
         {
-            if (!_transport.write(inData1))
+            if (!write(inData1))
             {
                 return false;
             }
@@ -349,12 +544,12 @@ bool Base::sendCommon(messageType_t inType, uint8_t inData1)
 
         case messageType_t::SYS_COMMON_SONG_POSITION:
         {
-            if (!_transport.write(inData1 & 0x7F))
+            if (!write(inData1 & 0x7F))
             {
                 return false;
             }
 
-            if (!_transport.write((inData1 >> 7) & 0x7F))
+            if (!write((inData1 >> 7) & 0x7F))
             {
                 return false;
             }
@@ -363,7 +558,7 @@ bool Base::sendCommon(messageType_t inType, uint8_t inData1)
 
         case messageType_t::SYS_COMMON_SONG_SELECT:
         {
-            if (!_transport.write(inData1 & 0x7F))
+            if (!write(inData1 & 0x7F))
             {
                 return false;
             }
@@ -377,13 +572,7 @@ bool Base::sendCommon(messageType_t inType, uint8_t inData1)
             break;
         }
 
-        if (_transport.endTransmission())
-        {
-            if (_useRunningStatus)
-            {
-                _mRunningStatusTX = static_cast<uint8_t>(messageType_t::INVALID);
-            }
-        }
+        return endTransmission(inType);
     }
 
     return false;
@@ -397,7 +586,8 @@ bool Base::sendCommon(messageType_t inType, uint8_t inData1)
 ///                     sysRealTimeContinue
 ///                     sysRealTimeActiveSensing
 ///                     sysRealTimeSystemReset
-bool Base::sendRealTime(messageType_t inType)
+template<typename TransportT>
+bool BasicMidi<TransportT>::sendRealTime(messageType_t inType)
 {
     switch (inType)
     {
@@ -408,14 +598,14 @@ bool Base::sendRealTime(messageType_t inType)
     case messageType_t::SYS_REAL_TIME_ACTIVE_SENSING:
     case messageType_t::SYS_REAL_TIME_SYSTEM_RESET:
     {
-        if (_transport.beginTransmission(inType))
+        if (beginTransmission(inType))
         {
-            if (!_transport.write(static_cast<uint8_t>(inType)))
+            if (!write(static_cast<uint8_t>(inType)))
             {
                 return false;
             }
 
-            return _transport.endTransmission();
+            return endTransmission(inType);
         }
     }
     break;
@@ -427,6 +617,39 @@ bool Base::sendRealTime(messageType_t inType)
     return false;
 }
 
+/// Queues Real Time message to be sent as soon as possible, even in the middle of SysEx message
+/// which is being sent. Safe to call from interrupt, for instance from the timer generating clock,
+/// as long as it's always called from the same context.
+/// Queued messages are sent by sendPendingRealTime(), tick() and between slices of SysEx message.
+/// param inType [in]  Real Time message type.
+/// returns: False if the type isn't Real Time message or if too many messages are pending.
+template<typename TransportT>
+bool BasicMidi<TransportT>::injectRealTime(messageType_t inType)
+{
+    if (!IS_SYSTEM_REAL_TIME(inType))
+    {
+        return false;
+    }
+
+    return _pendingRealTime.push(static_cast<uint8_t>(inType));
+}
+
+/// Sends all the Real Time messages queued with injectRealTime().
+/// returns: False if any of the messages couldn't be sent.
+template<typename TransportT>
+bool BasicMidi<TransportT>::sendPendingRealTime()
+{
+    bool    result = true;
+    uint8_t data   = 0;
+
+    while (_pendingRealTime.pop(data))
+    {
+        result &= sendRealTime(static_cast<messageType_t>(data));
+    }
+
+    return result;
+}
+
 /// Sends transport control messages.
 /// Based on MIDI specification for transport control.
 /// param deviceID  [in]    See transport control spec.
@@ -436,7 +659,8 @@ bool Base::sendRealTime(messageType_t inType)
 ///                         mmcPause
 ///                         mmcRecordStart
 ///                         mmcRecordStop
-bool Base::sendMMC(uint8_t deviceID, messageType_t mmc)
+template<typename TransportT>
+bool BasicMidi<TransportT>::sendMMC(uint8_t deviceID, messageType_t mmc)
 {
     switch (mmc)
     {
@@ -458,7 +682,8 @@ bool Base::sendMMC(uint8_t deviceID, messageType_t mmc)
     return sendSysEx(6, mmcArray, true);
 }
 
-bool Base::sendNRPN(uint16_t inParameterNumber, uint16_t inValue, uint8_t inChannel, bool value14bit)
+template<typename TransportT>
+bool BasicMidi<TransportT>::sendNRPN(uint16_t inParameterNumber, uint16_t inValue, uint8_t inChannel, bool value14bit)
 {
     auto inParameterNumberSplit = Split14Bit(inParameterNumber);
 
@@ -487,7 +712,8 @@ bool Base::sendNRPN(uint16_t inParameterNumber, uint16_t inValue, uint8_t inChan
     return sendControlChange(38, inValueSplit.low(), inChannel);
 }
 
-bool Base::sendControlChange14bit(uint16_t inControlNumber, uint16_t inControlValue, uint8_t inChannel)
+template<typename TransportT>
+bool BasicMidi<TransportT>::sendControlChange14bit(uint16_t inControlNumber, uint16_t inControlValue, uint8_t inChannel)
 {
     auto inControlValueSplit = Split14Bit(inControlValue);
 
@@ -501,468 +727,1040 @@ bool Base::sendControlChange14bit(uint16_t inControlNumber, uint16_t inControlVa
 
 /// Enable or disable running status.
 /// param [in] state   True when enabling running status, false otherwise.
-void Base::setRunningStatusState(bool state)
+template<typename TransportT>
+void BasicMidi<TransportT>::setRunningStatusState(bool state)
 {
     _useRunningStatus = state;
 }
 
+/// Sets the amount of bytes after which the status byte is sent again even if it could be omitted,
+/// so that a receiver which started listening mid-stream picks up the running status.
+/// param bytes [in]   Amount of data bytes sent with running status, 0 to disable refreshing.
+template<typename TransportT>
+void BasicMidi<TransportT>::setRunningStatusRefresh(uint16_t bytes)
+{
+    _runningStatusRefresh = bytes;
+}
+
+/// Forces the status byte to be sent with the next channel message.
+/// Call periodically, for instance from a timer, to refresh running status at a fixed interval.
+template<typename TransportT>
+void BasicMidi<TransportT>::refreshRunningStatus()
+{
+    _transport.setRunningStatus(static_cast<uint8_t>(messageType_t::INVALID));
+}
+
 /// Returns current running status state for outgoing DIN MIDI messages.
 /// returns: True if running status is enabled, false otherwise.
-bool Base::runningStatusState()
+template<typename TransportT>
+bool BasicMidi<TransportT>::runningStatusState()
 {
     return _useRunningStatus;
 }
 
-/// Calculates MIDI status byte for a given message type and channel.
-/// param inType [in]      MIDI message type.
-/// param inChannel [in]   MIDI channel.
-/// returns: Calculated status byte.
-uint8_t Base::status(messageType_t inType, uint8_t inChannel)
+/// Checks whether status byte of a channel message can be left out.
+/// Real Time messages don't affect running status and are sent transparently between
+/// channel messages. Running status is used only with transport interfaces which allow it.
+/// param status [in]  Status byte of the message about to be sent.
+template<typename TransportT>
+bool BasicMidi<TransportT>::omitStatus(uint8_t status)
 {
-    return (static_cast<uint8_t>(inType) | ((inChannel - 1) & 0x0f));
+    if (!_useRunningStatus || (status != _transport.runningStatus()) || !_transport.byteStream())
+    {
+        return false;
+    }
+
+    return !_runningStatusRefresh || (_runningStatusBytes < _runningStatusRefresh);
 }
 
-/// Reads from transport interface and tries to parse MIDI message.
-/// A valid message is a message that matches the input channel.
-/// If any thru interface is registered, parsed message is sent to it.
-/// returns: True on successful read.
-bool Base::read()
+/// Starts transmission of a message on transport interface.
+/// Failures are counted in stats when MIDI_STATS is enabled.
+template<typename TransportT>
+bool BasicMidi<TransportT>::beginTransmission(messageType_t type)
 {
-    if (!parse())
+    if (!_transport.beginTransmission(type))
     {
+        MIDI_STAT(_stats.sendFailures++);
         return false;
     }
 
-    thru();
-
     return true;
 }
 
-/// Handles parsing of MIDI messages.
-bool Base::parse()
+/// Writes single byte of the current message to transport interface.
+template<typename TransportT>
+bool BasicMidi<TransportT>::write(uint8_t data)
 {
-    uint8_t data = 0;
-
-    if (!_transport.read(data))
+    if (!_transport.write(data))
     {
-        return false;    // no data available
+        MIDI_STAT(_stats.sendFailures++);
+        return false;
     }
 
-    const uint8_t EXTRACTED = data;
+    MIDI_STAT(_stats.bytesOut++);
+    return true;
+}
 
-    if (_pendingMessageIndex == 0)
+/// Writes block of data of the current message to transport interface.
+template<typename TransportT>
+bool BasicMidi<TransportT>::write(const uint8_t* data, size_t size)
+{
+    if (!_transport.write(data, size))
     {
-        // start a new pending message
-        _mPendingMessage[0] = EXTRACTED;
+        MIDI_STAT(_stats.sendFailures++);
+        return false;
+    }
 
-        // check for running status first (din only)
-        if (IS_CHANNEL_MESSAGE(TYPE_FROM_STATUS_BYTE(_mRunningStatusRX)))
-        {
-            // Only channel messages allow Running Status.
-            // If the status byte is not received, prepend it to the pending message.
-            if (EXTRACTED < 0x80)
-            {
-                _mPendingMessage[0]  = _mRunningStatusRX;
-                _mPendingMessage[1]  = EXTRACTED;
-                _pendingMessageIndex = 1;
-            }
+    MIDI_STAT(_stats.bytesOut += size);
+    return true;
+}
 
-            // Else: well, we received another status byte,
-            // so the running status does not apply here.
-            // It will be updated upon completion of this message.
-        }
+/// Completes transmission of a message on transport interface.
+/// param type [in]    Type of the sent message, used for stats.
+template<typename TransportT>
+bool BasicMidi<TransportT>::endTransmission([[maybe_unused]] messageType_t type)
+{
+    if (!_transport.endTransmission())
+    {
+        MIDI_STAT(_stats.sendFailures++);
+        return false;
+    }
 
-        const auto PENDING_TYPE = TYPE_FROM_STATUS_BYTE(_mPendingMessage[0]);
+    MIDI_STAT(_stats.sent[Stats::index(type)]++);
+    return true;
+}
 
-        switch (PENDING_TYPE)
-        {
-        // 1 byte messages
-        case messageType_t::SYS_REAL_TIME_START:
-        case messageType_t::SYS_REAL_TIME_CONTINUE:
-        case messageType_t::SYS_REAL_TIME_STOP:
-        case messageType_t::SYS_REAL_TIME_CLOCK:
-        case messageType_t::SYS_REAL_TIME_ACTIVE_SENSING:
-        case messageType_t::SYS_REAL_TIME_SYSTEM_RESET:
-        case messageType_t::SYS_COMMON_TUNE_REQUEST:
-        {
-            // handle the message type directly here
-            _message.type    = PENDING_TYPE;
-            _message.channel = 0;
-            _message.data1   = 0;
-            _message.data2   = 0;
-            _message.valid   = true;
+/// Orders events in the output queue: the earliest one is placed on top of the heap.
+/// returns: True if the first event is to be sent after the second one.
+template<typename TransportT>
+bool BasicMidi<TransportT>::later(const ScheduledEvent& first, const ScheduledEvent& second)
+{
+    const auto DIFFERENCE = static_cast<int32_t>(first.time - second.time);
 
-            // do not reset all input attributes: running status must remain unchanged
-            // we still need to reset these
-            _pendingMessageIndex          = 0;
-            _pendingMessageExpectedLength = 0;
+    if (DIFFERENCE)
+    {
+        return DIFFERENCE > 0;
+    }
 
-            return true;
-        }
-        break;
+    return static_cast<int32_t>(first.sequence - second.sequence) > 0;
+}
 
-        // 2 bytes messages
-        case messageType_t::PROGRAM_CHANGE:
-        case messageType_t::AFTER_TOUCH_CHANNEL:
-        case messageType_t::SYS_COMMON_TIME_CODE_QUARTER_FRAME:
-        case messageType_t::SYS_COMMON_SONG_SELECT:
-        {
-            _pendingMessageExpectedLength = 2;
-        }
-        break;
+/// Adds event to the specified output queue.
+/// returns: False if the queue is full, true otherwise.
+template<typename TransportT>
+bool BasicMidi<TransportT>::enqueue(std::array<ScheduledEvent, MIDI_OUTPUT_QUEUE_SIZE>& queue, size_t& count, ScheduledEvent& event)
+{
+    if (count == queue.size())
+    {
+        return false;
+    }
 
-        // 3 bytes messages
-        case messageType_t::NOTE_ON:
-        case messageType_t::NOTE_OFF:
-        case messageType_t::CONTROL_CHANGE:
-        case messageType_t::PITCH_BEND:
-        case messageType_t::AFTER_TOUCH_POLY:
-        case messageType_t::SYS_COMMON_SONG_POSITION:
-        {
-            _pendingMessageExpectedLength = 3;
-        }
-        break;
+    event.sequence = _scheduleSequence++;
+    queue[count++] = event;
 
-        case messageType_t::SYS_EX:
-        {
-            // the message can be any length between 3 and MIDI_SYSEX_ARRAY_SIZE
-            _pendingMessageExpectedLength = MIDI_SYSEX_ARRAY_SIZE;
-            _mRunningStatusRX             = static_cast<uint8_t>(messageType_t::INVALID);
-            _message.sysexArray[0]        = static_cast<uint8_t>(messageType_t::SYS_EX);
-        }
-        break;
+    std::push_heap(queue.begin(), queue.begin() + count, later);
+    return true;
+}
 
-        case messageType_t::INVALID:
-        default:
-        {
-            reset();
+/// Removes the earliest event from the specified output queue, which must not be empty.
+template<typename TransportT>
+typename BasicMidi<TransportT>::ScheduledEvent BasicMidi<TransportT>::dequeue(std::array<ScheduledEvent, MIDI_OUTPUT_QUEUE_SIZE>& queue, size_t& count)
+{
+    std::pop_heap(queue.begin(), queue.begin() + count, later);
+    return queue[--count];
+}
 
-            return false;
-        }
-        break;
-        }
+/// Sends event retrieved from the output queue.
+/// SysEx message is only started here if it's sent in parts.
+template<typename TransportT>
+bool BasicMidi<TransportT>::sendScheduled(const ScheduledEvent& event)
+{
+    const auto& MESSAGE = event.message;
 
-        if (_pendingMessageIndex >= (_pendingMessageExpectedLength - 1))
-        {
-            // reception complete
-            _message.type                 = PENDING_TYPE;
-            _message.channel              = CHANNEL_FROM_STATUS_BYTE(_mPendingMessage[0]);
-            _message.data1                = _mPendingMessage[1];
-            _message.data2                = 0;
-            _message.length               = 1;
-            _pendingMessageIndex          = 0;
-            _pendingMessageExpectedLength = 0;
-            _message.valid                = true;
+    if (MESSAGE.type != messageType_t::SYS_EX)
+    {
+        return send(MESSAGE);
+    }
 
-            return true;
-        }
+    if (_sysExChunkSize && _transport.byteStream())
+    {
+        _sysExData      = event.data;
+        _sysExRemaining = MESSAGE.length;
 
-        // waiting for more data
-        _pendingMessageIndex++;
+        return sendSysExChunk();
+    }
+
+    return sendSysEx(MESSAGE.length, event.data, true);
+}
+
+/// Sends next part of SysEx message started by sendScheduled().
+/// Message is counted in stats once its last part is sent.
+/// Remaining parts are dropped if sending fails.
+template<typename TransportT>
+bool BasicMidi<TransportT>::sendSysExChunk()
+{
+    // chunk size could have been cleared in the meantime: the rest is then sent at once
+    const uint16_t SIZE   = _sysExChunkSize ? std::min(_sysExRemaining, _sysExChunkSize) : _sysExRemaining;
+    bool           result = beginTransmission(messageType_t::SYS_EX);
+
+    // SysEx cancels running status on the receiving side
+    _transport.setRunningStatus(static_cast<uint8_t>(messageType_t::INVALID));
+
+    result = result && write(_sysExData, SIZE) && writePendingRealTime();
+    _sysExData += SIZE;
+    _sysExRemaining -= SIZE;
+
+    if (_sysExRemaining)
+    {
+        result = result && _transport.endTransmission();
+    }
+    else
+    {
+        result = result && endTransmission(messageType_t::SYS_EX);
+    }
+
+    if (!result)
+    {
+        _sysExRemaining = 0;
+    }
+
+    return result;
+}
+
+/// Writes Real Time messages queued with injectRealTime() into the message being sent.
+/// Transport interfaces take care of Real Time bytes written within SysEx message.
+template<typename TransportT>
+bool BasicMidi<TransportT>::writePendingRealTime()
+{
+    uint8_t data = 0;
 
-        if (!_recursiveParseState)
+    while (_pendingRealTime.pop(data))
+    {
+        if (!write(data))
         {
-            // message is not complete
             return false;
         }
 
-        return parse();
+        MIDI_STAT(_stats.sent[Stats::index(static_cast<messageType_t>(data))]++);
     }
 
-    // first, test if this is a status byte
-    if (EXTRACTED >= 0x80)
+    return true;
+}
+
+/// Calculates MIDI status byte for a given message type and channel.
+/// param inType [in]      MIDI message type.
+/// param inChannel [in]   MIDI channel.
+/// returns: Calculated status byte.
+template<typename TransportT>
+uint8_t BasicMidi<TransportT>::status(messageType_t inType, uint8_t inChannel)
+{
+    return (static_cast<uint8_t>(inType) | ((inChannel - 1) & 0x0f));
+}
+
+/// Reads from transport interface and tries to parse MIDI message.
+/// A valid message is a message that matches the input channel.
+/// If any thru interface is registered, parsed message is sent to it.
+/// returns: True on successful read.
+template<typename TransportT>
+bool BasicMidi<TransportT>::read()
+{
+    if (!parse())
     {
-        // Reception of status bytes in the middle of an uncompleted message
-        // are allowed only for interleaved Real Time message or EOX.
-        switch (EXTRACTED)
-        {
-        case static_cast<uint8_t>(messageType_t::SYS_REAL_TIME_CLOCK):
-        case static_cast<uint8_t>(messageType_t::SYS_REAL_TIME_START):
-        case static_cast<uint8_t>(messageType_t::SYS_REAL_TIME_CONTINUE):
-        case static_cast<uint8_t>(messageType_t::SYS_REAL_TIME_STOP):
-        case static_cast<uint8_t>(messageType_t::SYS_REAL_TIME_ACTIVE_SENSING):
-        case static_cast<uint8_t>(messageType_t::SYS_REAL_TIME_SYSTEM_RESET):
-        {
-            // Here we will have to extract the one-byte message,
-            // pass it to the structure for being read outside
-            // the MIDI class, and recompose the message it was
-            // interleaved into without killing the running status..
-            // This is done by leaving the pending message as is,
-            // it will be completed on next calls.
-            _message.type    = static_cast<messageType_t>(EXTRACTED);
-            _message.data1   = 0;
-            _message.data2   = 0;
-            _message.channel = 0;
-            _message.length  = 1;
-            _message.valid   = true;
+        return false;
+    }
 
-            return true;
-        }
-        break;
+    thru();
 
-        // end of sysex
-        case 0xF7:
+    return true;
+}
+
+/// Reads MIDI message like read(), but if none is available, blocks until the
+/// transport receives new data instead of returning at once.
+/// Parts of incomplete message don't extend the wait: every wait gets only the time
+/// which is left, as reported back by the transport. If the transport can't wait
+/// for data, this is the same as read().
+/// param timeout [in]    Maximum time to wait for a message, in milliseconds.
+/// returns: True on successful read, false on timeout.
+template<typename TransportT>
+bool BasicMidi<TransportT>::read(uint32_t timeout)
+{
+    uint32_t remaining = timeout;
+
+    while (!read())
+    {
+        if (!remaining || !_transport.wait(remaining))
         {
-            if (_message.sysexArray[0] == static_cast<uint8_t>(messageType_t::SYS_EX))
-            {
-                // store the last byte (EOX)
-                _message.sysexArray[_pendingMessageIndex++] = 0xF7;
-                _message.type                               = messageType_t::SYS_EX;
+            return false;
+        }
+    }
 
-                // get length
-                _message.data1   = 0;
-                _message.data2   = 0;
-                _message.channel = 0;
-                _message.length  = _pendingMessageIndex;
-                _message.valid   = true;
+    return true;
+}
 
-                reset();
-                return true;
-            }
+/// Decodes all the data currently available from transport interface into the message queue.
+/// See poll().
+/// returns: Amount of messages added to the queue.
+template<typename TransportT>
+size_t BasicMidi<TransportT>::readAll()
+{
+    return poll(_queue.size());
+}
 
-            // error
-            reset();
-            return false;
+/// Reads from transport interface and stores decoded messages into the message queue
+/// until the specified amount of messages is decoded, queue is full or there is no more data.
+/// Every decoded message is also sent to registered thru interfaces.
+/// Queued messages can be retrieved with queuedMessage() or pop().
+/// Decoding stops after a SysEx message is queued: its payload is available
+/// with sysExArray() until the next call to read(), poll() or readAll().
+/// Queue size is set with MIDI_MESSAGE_QUEUE_SIZE: nothing is read if the queue is disabled.
+/// param maxMessages [in]     Maximum amount of messages to decode.
+/// returns: Amount of messages added to the queue.
+template<typename TransportT>
+size_t BasicMidi<TransportT>::poll(size_t maxMessages)
+{
+    size_t count = 0;
+
+    while ((count < maxMessages) && (_queueCount < _queue.size()))
+    {
+        const auto RESULT = receive();
+
+        if (RESULT == readResult_t::NO_DATA)
+        {
+            break;
         }
-        break;
 
-        // start of sysex
-        case 0xF0:
+        if (RESULT != readResult_t::MESSAGE)
         {
-            // reset the parsing of sysex
-            _message.sysexArray[0] = static_cast<uint8_t>(messageType_t::SYS_EX);
-            _pendingMessageIndex   = 1;
+            continue;
         }
-        break;
 
-        default:
+        thru();
+
+        auto index = _queueHead + _queueCount;
+
+        if (index >= _queue.size())
+        {
+            index -= _queue.size();
+        }
+
+        _queue[index] = _message;
+        _queueCount++;
+        count++;
+
+        if (_message.type == messageType_t::SYS_EX)
+        {
+            // SysEx payload is kept in sysExArray() only until the next SysEx message
             break;
         }
     }
 
-    // add extracted data byte to pending message
-    if (_mPendingMessage[0] == static_cast<uint8_t>(messageType_t::SYS_EX))
+    return count;
+}
+
+/// Checks how many decoded messages are stored in the message queue.
+template<typename TransportT>
+size_t BasicMidi<TransportT>::queued()
+{
+    return _queueCount;
+}
+
+/// Retrieves queued message without removing it from the queue.
+/// param index [in]   Position of the message in the queue, 0 being the oldest one.
+///                    Must be lower than queued().
+template<typename TransportT>
+Message& BasicMidi<TransportT>::queuedMessage(size_t index)
+{
+    index += _queueHead;
+
+    if (index >= _queue.size())
     {
-        _message.sysexArray[_pendingMessageIndex] = EXTRACTED;
+        index -= _queue.size();
     }
-    else
+
+    return _queue[index];
+}
+
+/// Removes the oldest message from the message queue.
+/// param message [in,out]     Retrieved message.
+/// returns: True if the message was retrieved, false if the queue is empty.
+template<typename TransportT>
+bool BasicMidi<TransportT>::pop(Message& message)
+{
+    if (!_queueCount)
     {
-        _mPendingMessage[_pendingMessageIndex] = EXTRACTED;
+        return false;
     }
 
-    // now we are going to check if we have reached the end of the message
-    if (_pendingMessageIndex >= (_pendingMessageExpectedLength - 1))
+    message = _queue[_queueHead++];
+    _queueCount--;
+
+    if (_queueHead >= _queue.size())
     {
-        //"FML" case: fall down here with an overflown SysEx..
-        // This means we received the last possible data byte that can fit the buffer.
-        // If this happens, try increasing MIDI_SYSEX_ARRAY_SIZE.
-        if (_mPendingMessage[0] == static_cast<uint8_t>(messageType_t::SYS_EX))
+        _queueHead = 0;
+    }
+
+    return true;
+}
+
+/// Removes all messages from the message queue.
+template<typename TransportT>
+void BasicMidi<TransportT>::clearQueue()
+{
+    _queueHead  = 0;
+    _queueCount = 0;
+}
+
+/// Adds outgoing message to the output queue, to be sent by tick() once the specified time is reached.
+/// Messages scheduled for the same time are sent in the order in which they were scheduled.
+/// Real Time messages are kept in a separate queue: they are sent before any other message
+/// due at the same time, and also between the parts of SysEx message (see setSysExChunkSize()).
+/// Queue size is set with MIDI_OUTPUT_QUEUE_SIZE: nothing can be scheduled if the queue is disabled.
+/// param message [in]     Channel, System Common or Real Time message to send.
+/// param time [in]        Time at which the message is sent, in the same units as time passed to tick().
+/// returns: False if the message can't be scheduled or if the queue is full, true otherwise.
+template<typename TransportT>
+bool BasicMidi<TransportT>::schedule(const Message& message, uint32_t time)
+{
+    if ((message.type == messageType_t::SYS_EX) || (message.type == messageType_t::INVALID))
+    {
+        return false;
+    }
+
+    ScheduledEvent event;
+
+    event.message = message;
+    event.time    = time;
+
+    if (IS_SYSTEM_REAL_TIME(message.type))
+    {
+        return enqueue(_realTimeSchedule, _realTimeScheduleCount, event);
+    }
+
+    return enqueue(_schedule, _scheduleCount, event);
+}
+
+/// Adds SysEx message to the output queue, to be sent by tick() once the specified time is reached.
+/// Message isn't copied: the buffer must remain valid until the message is sent.
+/// param data [in]        SysEx message, including 0xF0 and 0xF7 bytes.
+/// param length [in]      Length of the message.
+/// param time [in]        Time at which the message is sent, in the same units as time passed to tick().
+/// returns: False if the message is invalid or if the queue is full, true otherwise.
+template<typename TransportT>
+bool BasicMidi<TransportT>::scheduleSysEx(const uint8_t* data, uint16_t length, uint32_t time)
+{
+    if ((length < 2) || (data[0] != 0xF0) || (data[length - 1] != 0xF7))
+    {
+        return false;
+    }
+
+    ScheduledEvent event;
+
+    event.message.type   = messageType_t::SYS_EX;
+    event.message.length = length;
+    event.time           = time;
+    event.data           = data;
+
+    return enqueue(_schedule, _scheduleCount, event);
+}
+
+/// Sends all the scheduled messages whose time has been reached.
+/// Needs to be called periodically: the interval between the calls sets the timing resolution.
+/// Real Time messages are sent first. While SysEx message is being sent in parts, other
+/// messages wait until its last part is sent, except Real Time ones. In the meantime, only
+/// Real Time messages can be sent directly: other send functions fail instead of breaking the SysEx message.
+/// param time [in]    Current time, in any units as long as the messages are scheduled with the same ones.
+/// returns: Amount of sent messages.
+template<typename TransportT>
+size_t BasicMidi<TransportT>::tick(uint32_t time)
+{
+    size_t count = 0;
+
+    sendPendingRealTime();
+
+    while (_realTimeScheduleCount && (static_cast<int32_t>(time - _realTimeSchedule[0].time) >= 0))
+    {
+        count += sendScheduled(dequeue(_realTimeSchedule, _realTimeScheduleCount));
+    }
+
+    if (_sysExRemaining)
+    {
+        sendSysExChunk();
+
+        if (_sysExRemaining)
         {
-            reset();
-            return false;
+            return count;
         }
+    }
 
-        _message.type = TYPE_FROM_STATUS_BYTE(_mPendingMessage[0]);
+    while (_scheduleCount && (static_cast<int32_t>(time - _schedule[0].time) >= 0))
+    {
+        count += sendScheduled(dequeue(_schedule, _scheduleCount));
 
-        if (IS_CHANNEL_MESSAGE(_message.type))
+        if (_sysExRemaining)
         {
-            _message.channel = CHANNEL_FROM_STATUS_BYTE(_mPendingMessage[0]);
+            // rest of the message is sent on the next ticks
+            break;
         }
-        else
+    }
+
+    return count;
+}
+
+/// Checks how many messages are waiting in the output queues.
+template<typename TransportT>
+size_t BasicMidi<TransportT>::scheduled()
+{
+    return _scheduleCount + _realTimeScheduleCount;
+}
+
+/// Removes all messages from the output queues.
+/// SysEx message which is partially sent is completed on the next tick().
+template<typename TransportT>
+void BasicMidi<TransportT>::clearSchedule()
+{
+    _scheduleCount         = 0;
+    _realTimeScheduleCount = 0;
+}
+
+/// Sets the maximum amount of bytes of scheduled SysEx message sent on a single tick(),
+/// and the size of slices after which injected Real Time messages are sent by sendSysEx().
+/// Splitting long message allows Real Time messages to be sent between its parts:
+/// with size set to 1, they are sent at byte boundaries. Scheduled SysEx messages are split
+/// only on transport interfaces which transfer plain byte stream. New size applies from the
+/// next part of the message which is being sent: with 0, its remaining part is sent at once.
+/// param size [in]    Amount of bytes, or 0 to send the entire message at once.
+template<typename TransportT>
+void BasicMidi<TransportT>::setSysExChunkSize(uint16_t size)
+{
+    _sysExChunkSize = size;
+}
+
+/// Handles parsing of MIDI messages.
+/// Bytes are consumed until a message is complete or until there is no more data
+/// available. If recursive parsing is disabled, only one byte is consumed per call.
+template<typename TransportT>
+bool BasicMidi<TransportT>::parse()
+{
+    while (true)
+    {
+        switch (receive())
         {
-            _message.channel = 0;
-        }
+        case readResult_t::MESSAGE:
+            return true;
 
-        _message.data1 = _mPendingMessage[1];
+        case readResult_t::NO_DATA:
+            return false;
 
-        // save data2 only if applicable
-        if (_pendingMessageExpectedLength == 3)
+        default:
         {
-            _message.data2 = _mPendingMessage[2];
+            if (!_recursiveParseState)
+            {
+                return false;    // message is not complete
+            }
         }
-        else
-        {
-            _message.data2 = 0;
+        break;
         }
+    }
+}
 
-        _message.length = _pendingMessageExpectedLength;
+/// Retrieves next message from transport interface if it can be decoded directly,
+/// otherwise reads single byte and passes it to the parser.
+/// returns: readResult_t::MESSAGE if a message is complete, readResult_t::RAW if a byte has been
+///          consumed without completing a message and readResult_t::NO_DATA if nothing was read.
+template<typename TransportT>
+readResult_t BasicMidi<TransportT>::receive()
+{
+    const auto RESULT = _transport.readMessage(_message);
+
+    if (RESULT == readResult_t::MESSAGE)
+    {
+        acceptMessage();
+        _timestamp = _transport.timestamp();
+        return readResult_t::MESSAGE;
+    }
+
+    if (RESULT == readResult_t::NO_DATA)
+    {
+        return readResult_t::NO_DATA;
+    }
+
+    uint8_t data = 0;
+
+    if (!_transport.read(data))
+    {
+        return readResult_t::NO_DATA;
+    }
+
+    if (!parseByte(data))
+    {
+        return readResult_t::RAW;
+    }
 
-        // reset local variables
-        _pendingMessageIndex          = 0;
-        _pendingMessageExpectedLength = 0;
-        _message.valid                = true;
+    _timestamp = _transport.timestamp();
+    return readResult_t::MESSAGE;
+}
 
-        // activate running status (if enabled for the received type)
-        switch (_message.type)
+/// Updates parser state after message has been decoded by transport interface.
+/// Message is handled in the same way as if it was received byte by byte:
+/// incomplete message is dropped unless the new one is Real Time message.
+template<typename TransportT>
+void BasicMidi<TransportT>::acceptMessage()
+{
+    if (!IS_SYSTEM_REAL_TIME(_message.type))
+    {
+        if (_pendingMessageExpectedLength)
         {
-        case messageType_t::NOTE_OFF:
-        case messageType_t::NOTE_ON:
-        case messageType_t::AFTER_TOUCH_POLY:
-        case messageType_t::CONTROL_CHANGE:
-        case messageType_t::PROGRAM_CHANGE:
-        case messageType_t::AFTER_TOUCH_CHANNEL:
-        case messageType_t::PITCH_BEND:
+            MIDI_STAT(_stats.parseErrors[static_cast<size_t>(parseError_t::INTERRUPTED)]++);
+            abortSysExStream();
+
+            _pendingMessageExpectedLength = 0;
+            _pendingMessageIndex          = 0;
+        }
+
+        _mRunningStatusRX = IS_CHANNEL_MESSAGE(_message.type) ? status(_message.type, _message.channel) : static_cast<uint8_t>(messageType_t::INVALID);
+        _rxRunningStatus  = false;
+    }
+
+    MIDI_STAT(_stats.bytesIn += _message.length);
+    MIDI_STAT(_stats.received[Stats::index(_message.type)]++);
+}
+
+/// Decodes all MIDI messages found in provided buffer in a single pass.
+/// Parsing state is shared with parse(): running status, interleaved Real Time
+/// messages and SysEx messages split between several buffers are handled in the same way.
+/// Thru interfaces aren't used here. Payload of SysEx message passed to the sink
+/// can be retrieved with sysExArray().
+/// param data [in]    Buffer holding raw MIDI bytes.
+/// param size [in]    Amount of bytes in the buffer.
+/// param sink [in]    Interface to which every decoded message is passed.
+/// returns: Amount of decoded messages.
+template<typename TransportT>
+size_t BasicMidi<TransportT>::parse(const uint8_t* data, size_t size, Sink& sink)
+{
+    size_t count = 0;
+
+    for (size_t i = 0; i < size; i++)
+    {
+        if (parseByte(data[i]))
         {
-            // running status enabled: store it from received message
-            _mRunningStatusRX = _mPendingMessage[0];
+            _timestamp = 0;
+            sink.process(_message);
+            count++;
         }
-        break;
+    }
 
-        default:
+    return count;
+}
+
+/// Feeds single byte to the parser.
+/// Status bytes are classified using STATUS_TABLE so that every byte is handled
+/// with a constant amount of work and without recursion.
+/// param data [in]    Received byte.
+/// returns: True if the byte completed a message, false otherwise.
+template<typename TransportT>
+bool BasicMidi<TransportT>::parseByte(uint8_t data)
+{
+    const uint8_t INFO = STATUS_TABLE[data];
+
+    MIDI_STAT(_stats.bytesIn++);
+
+    if (data < 0x80)
+    {
+        if (!_pendingMessageExpectedLength)
         {
-            // no running status
-            _mRunningStatusRX = static_cast<uint8_t>(messageType_t::INVALID);
+            if (!_mRunningStatusRX)
+            {
+                // data byte without status byte, nothing to do with it
+                MIDI_STAT(_stats.parseErrors[static_cast<size_t>(parseError_t::MISSING_STATUS)]++);
+                return false;
+            }
+
+            MIDI_STAT(_stats.runningStatusIn++);
+
+            // running status: status byte is omitted, prepend the last one to the pending message
+            _mPendingMessage[0]           = _mRunningStatusRX;
+            _pendingMessageExpectedLength = STATUS_TABLE[_mRunningStatusRX] & STATUS_LENGTH_MASK;
+            _pendingMessageIndex          = 1;
+            _rxRunningStatus              = true;
         }
-        break;
+
+        if (_mPendingMessage[0] == static_cast<uint8_t>(messageType_t::SYS_EX))
+        {
+            if (_sysExStream != nullptr)
+            {
+                _sysExArray[_pendingMessageIndex++] = data;
+
+                if (_pendingMessageIndex == _sysExArray.size())
+                {
+                    // window is full: hand it over and start filling it again
+                    _sysExStream->sysExChunk(_sysExStreamActive ? sysExChunk_t::CONTINUE : sysExChunk_t::START,
+                                             _sysExArray.data(),
+                                             _pendingMessageIndex);
+
+                    _sysExStreamActive   = true;
+                    _pendingMessageIndex = 0;
+                }
+
+                return false;
+            }
+
+            if (_pendingMessageIndex >= (_pendingMessageExpectedLength - 1))
+            {
+                //"FML" case: there is no room left for the remaining data and EOX.
+                // If this happens, try increasing MIDI_SYSEX_ARRAY_SIZE.
+                MIDI_STAT(_stats.parseErrors[static_cast<size_t>(parseError_t::SYS_EX_OVERFLOW)]++);
+                reset();
+                return false;
+            }
+
+            _sysExArray[_pendingMessageIndex++] = data;
+            return false;
         }
 
+        _mPendingMessage[_pendingMessageIndex++] = data;
+    }
+    else if (INFO & STATUS_REAL_TIME)
+    {
+        // Real Time messages can be interleaved anywhere:
+        // pending message and running status remain unchanged.
+        _message.type    = static_cast<messageType_t>(data);
+        _message.channel = 0;
+        _message.data1   = 0;
+        _message.data2   = 0;
+        _message.length  = 1;
+        _message.valid   = true;
+
+        MIDI_STAT(_stats.received[Stats::index(_message.type)]++);
         return true;
     }
+    else if (INFO & STATUS_SYS_EX_END)
+    {
+        if (_pendingMessageExpectedLength && (_mPendingMessage[0] == static_cast<uint8_t>(messageType_t::SYS_EX)))
+        {
+            // store the last byte (EOX)
+            _sysExArray[_pendingMessageIndex++] = data;
 
-    // update the index of the pending message
-    _pendingMessageIndex++;
+            if (_sysExStream != nullptr)
+            {
+                _sysExStream->sysExChunk(_sysExStreamActive ? sysExChunk_t::END : sysExChunk_t::COMPLETE,
+                                         _sysExArray.data(),
+                                         _pendingMessageIndex);
 
-    if (!_recursiveParseState)
+                _sysExStreamActive = false;
+
+                MIDI_STAT(_stats.received[Stats::index(messageType_t::SYS_EX)]++);
+                reset();
+                return false;
+            }
+
+            _message.type    = messageType_t::SYS_EX;
+            _message.channel = 0;
+            _message.data1   = 0;
+            _message.data2   = 0;
+            _message.length  = _pendingMessageIndex;
+            _message.valid   = true;
+
+            MIDI_STAT(_stats.received[Stats::index(_message.type)]++);
+            reset();
+            return true;
+        }
+
+        // EOX without SysEx start
+        MIDI_STAT(_stats.parseErrors[static_cast<size_t>(parseError_t::STRAY_EOX)]++);
+        reset();
+        return false;
+    }
+    else if (INFO & STATUS_SYS_EX_START)
+    {
+        // SysEx can be any length up to MIDI_SYSEX_ARRAY_SIZE, unless it's streamed
+        MIDI_STAT(_stats.parseErrors[static_cast<size_t>(parseError_t::INTERRUPTED)] += (_pendingMessageExpectedLength != 0));
+        abortSysExStream();
+
+        _mPendingMessage[0]           = data;
+        _sysExArray[0]                = data;
+        _pendingMessageIndex          = 1;
+        _pendingMessageExpectedLength = MIDI_SYSEX_ARRAY_SIZE;
+        _mRunningStatusRX             = static_cast<uint8_t>(messageType_t::INVALID);
+
+        return false;
+    }
+    else if (INFO & STATUS_LENGTH_MASK)
     {
-        return false;    // message is not complete.
+        // new status byte, any incomplete message is dropped
+        MIDI_STAT(_stats.parseErrors[static_cast<size_t>(parseError_t::INTERRUPTED)] += (_pendingMessageExpectedLength != 0));
+        abortSysExStream();
+
+        _mPendingMessage[0]           = data;
+        _pendingMessageIndex          = 1;
+        _pendingMessageExpectedLength = INFO & STATUS_LENGTH_MASK;
+        _rxRunningStatus              = false;
     }
+    else
+    {
+        // undefined status byte
+        MIDI_STAT(_stats.parseErrors[static_cast<size_t>(parseError_t::UNDEFINED_STATUS)]++);
+        reset();
+        return false;
+    }
+
+    if (_pendingMessageIndex < _pendingMessageExpectedLength)
+    {
+        return false;    // waiting for more data
+    }
+
+    // reception complete
+    const uint8_t STATUS      = _mPendingMessage[0];
+    const uint8_t STATUS_INFO = STATUS_TABLE[STATUS];
+
+    _message.type    = TYPE_FROM_STATUS_BYTE(STATUS);
+    _message.channel = (STATUS_INFO & STATUS_RUNNING_STATUS) ? CHANNEL_FROM_STATUS_BYTE(STATUS) : 0;
+    _message.data1   = (_pendingMessageExpectedLength > 1) ? _mPendingMessage[1] : 0;
+    _message.data2   = (_pendingMessageExpectedLength > 2) ? _mPendingMessage[2] : 0;
+    _message.length  = _pendingMessageExpectedLength;
+    _message.valid   = true;
+
+    MIDI_STAT(_stats.received[Stats::index(_message.type)]++);
+
+    // only channel messages allow running status
+    _mRunningStatusRX             = (STATUS_INFO & STATUS_RUNNING_STATUS) ? STATUS : static_cast<uint8_t>(messageType_t::INVALID);
+    _pendingMessageIndex          = 0;
+    _pendingMessageExpectedLength = 0;
 
-    return parse();
+    return true;
 }
 
 /// Retrieves the MIDI message type of the last received message.
-messageType_t Base::type()
+template<typename TransportT>
+messageType_t BasicMidi<TransportT>::type()
 {
     return _message.type;
 }
 
 /// Retrieves the MIDI channel of the last received message.
-uint8_t Base::channel()
+template<typename TransportT>
+uint8_t BasicMidi<TransportT>::channel()
 {
     return _message.channel;
 }
 
 /// Retrieves the first data byte of the last received message.
-uint8_t Base::data1()
+template<typename TransportT>
+uint8_t BasicMidi<TransportT>::data1()
 {
     return _message.data1;
 }
 
 /// Retrieves the second data byte of the last received message.
-uint8_t Base::data2()
+template<typename TransportT>
+uint8_t BasicMidi<TransportT>::data2()
 {
     return _message.data2;
 }
 
 /// Retrieves memory location in which SysEx array is being stored.
-uint8_t* Base::sysExArray()
+template<typename TransportT>
+uint8_t* BasicMidi<TransportT>::sysExArray()
 {
-    return _message.sysexArray;
+    return _sysExArray.data();
 }
 
 /// Checks the size of last received MIDI message.
-uint16_t Base::length()
+template<typename TransportT>
+uint16_t BasicMidi<TransportT>::length()
 {
     return _message.length;
 }
 
-/// Used to enable or disable recursive parsing of incoming messages on UART interface.
+/// Retrieves the time at which the last received message was sent.
+/// Only available on transport interfaces which transfer timestamps, 0 otherwise.
+template<typename TransportT>
+uint32_t BasicMidi<TransportT>::timestamp()
+{
+    return _timestamp;
+}
+
+/// Used to enable or disable continuous parsing of incoming messages.
 /// Setting this to false will make MIDI.read parse only one byte of data for each
 /// call when data is available. This can speed up your application if receiving
 /// a lot of traffic, but might induce MIDI Thru and treatment latency.
+/// Parsing is iterative in both cases, so stack usage doesn't depend on message length.
 /// param state [in]   Set to true to enable recursive parsing or false to disable it.
-void Base::useRecursiveParsing(bool state)
+template<typename TransportT>
+void BasicMidi<TransportT>::useRecursiveParsing(bool state)
 {
     _recursiveParseState = state;
 }
 
-void Base::thru()
+/// Enables streaming of received SysEx messages.
+/// Instead of being stored in sysExArray() and limited to MIDI_SYSEX_ARRAY_SIZE bytes,
+/// SysEx messages are handed over to the stream in chunks of up to MIDI_SYSEX_ARRAY_SIZE
+/// bytes as they arrive, using the same buffer for every chunk. Streamed SysEx messages
+/// aren't reported by read() and aren't forwarded to thru interfaces.
+/// param stream [in]  Interface receiving SysEx chunks. Set to nullptr to disable streaming.
+template<typename TransportT>
+void BasicMidi<TransportT>::setSysExStream(SysExStream* stream)
+{
+    reset();
+    _sysExStream = stream;
+}
+
+/// Notifies SysEx stream that the message being streamed has been interrupted.
+template<typename TransportT>
+void BasicMidi<TransportT>::abortSysExStream()
+{
+    if (!_sysExStreamActive)
+    {
+        return;
+    }
+
+    _sysExStreamActive = false;
+
+    if (_sysExStream != nullptr)
+    {
+        _sysExStream->sysExChunk(sysExChunk_t::ABORT, nullptr, 0);
+    }
+}
+
+template<typename TransportT>
+void BasicMidi<TransportT>::thru()
 {
+    const bool     CHANNEL_MESSAGE = IS_CHANNEL_MESSAGE(_message.type);
+    const uint32_t TYPE_BIT        = ThruFilter::typeBit(_message.type);
+    const uint16_t CHANNEL_BIT     = CHANNEL_MESSAGE ? ThruFilter::channelBit(_message.channel) : ThruFilter::ALL_CHANNELS;
+    const bool     RAW_SOURCE      = _rxRunningStatus && _transport.byteStream();
+
     for (size_t i = 0; i < _thruInterface.size(); i++)
     {
-        auto interface = _thruInterface.at(i);
+        auto        interface = _thruInterface.at(i);
+        const auto& filter    = _thruFilter.at(i);
 
-        if (interface == nullptr)
+        if ((interface == nullptr) || !(filter.types & TYPE_BIT) || !(filter.channels & CHANNEL_BIT))
         {
             continue;
         }
 
-        if (interface->beginTransmission(_message.type))
+        bool result = interface->beginTransmission(_message.type);
+
+        if (result)
         {
             if (IS_SYSTEM_REAL_TIME(_message.type))
             {
-                interface->write(static_cast<uint8_t>(_message.type));
+                result &= interface->write(static_cast<uint8_t>(_message.type));
             }
-            else if (IS_CHANNEL_MESSAGE(_message.type))
+            else if (CHANNEL_MESSAGE)
             {
-                const auto IN_STATUS = status(_message.type, _message.channel);
-                interface->write(static_cast<uint8_t>(IN_STATUS));
+                const auto IN_STATUS = status(_message.type, filter.remap ? filter.remap : _message.channel);
+
+                // status byte is left out only if it was left out on input as well
+                // and the last message written to this interface, by any instance, had the same one
+                if (!filter.raw || !RAW_SOURCE || (interface->runningStatus() != IN_STATUS) || !interface->byteStream())
+                {
+                    result &= interface->write(static_cast<uint8_t>(IN_STATUS));
+                }
 
                 if (_message.length > 1)
                 {
-                    interface->write(_message.data1);
+                    result &= interface->write(_message.data1);
                 }
 
                 if (_message.length > 2)
                 {
-                    interface->write(_message.data2);
+                    result &= interface->write(_message.data2);
                 }
+
+                interface->setRunningStatus(IN_STATUS);
             }
             else if (_message.type == messageType_t::SYS_EX)
             {
-                const auto SIZE = _message.length;
-
-                for (size_t i = 0; i < SIZE; i++)
-                {
-                    interface->write(_message.sysexArray[i]);
-                }
+                result &= interface->write(_sysExArray.data(), _message.length);
+                interface->setRunningStatus(static_cast<uint8_t>(messageType_t::INVALID));
             }
             else    // at this point, it it assumed to be a system common message
             {
-                interface->write(static_cast<uint8_t>(_message.type));
+                result &= interface->write(static_cast<uint8_t>(_message.type));
+                interface->setRunningStatus(static_cast<uint8_t>(messageType_t::INVALID));
 
                 if (_message.length > 1)
                 {
-                    interface->write(_message.data1);
+                    result &= interface->write(_message.data1);
                 }
 
                 if (_message.length > 2)
                 {
-                    interface->write(_message.data2);
+                    result &= interface->write(_message.data2);
                 }
             }
         }
 
-        interface->endTransmission();
+        result &= interface->endTransmission();
+
+        if (!result)
+        {
+            // receiver state is unknown after failed transmission
+            interface->setRunningStatus(static_cast<uint8_t>(messageType_t::INVALID));
+        }
+
+        MIDI_STAT(_stats.thruDropped += !result);
     }
 }
 
 /// Configures how Note Off messages are sent.
 /// param type [in]    Type of MIDI Note Off message. See noteOffType_t.
-void Base::setNoteOffMode(noteOffType_t type)
+template<typename TransportT>
+void BasicMidi<TransportT>::setNoteOffMode(noteOffType_t type)
 {
     _noteOffMode = type;
 }
 
 /// Checks how MIDI Note Off messages are being sent.
-noteOffType_t Base::noteOffMode()
+template<typename TransportT>
+noteOffType_t BasicMidi<TransportT>::noteOffMode()
 {
     return _noteOffMode;
 }
 
-void Base::registerThruInterface(Thru& interface)
+/// Adds interface to which received messages are forwarded.
+/// param interface [in]    Thru interface.
+/// param filter [in]       Messages which are forwarded to the interface. By default, every message is forwarded.
+///                         With raw filter, channel messages received with running status are forwarded
+///                         without status byte whenever the interface is in the same running status state.
+template<typename TransportT>
+void BasicMidi<TransportT>::registerThruInterface(Thru& interface, const ThruFilter& filter)
 {
     for (size_t i = 0; i < _thruInterface.size(); i++)
     {
         if (_thruInterface.at(i) == nullptr)
         {
             _thruInterface[i] = &interface;
+            _thruFilter[i]    = filter;
             break;
         }
     }
 }
 
-void Base::unregisterThruInterface(Thru& interface)
+/// Changes the filter of already registered thru interface.
+/// param interface [in]    Thru interface.
+/// param filter [in]       Messages which are forwarded to the interface.
+/// returns: False if the interface isn't registered, true otherwise.
+template<typename TransportT>
+bool BasicMidi<TransportT>::setThruFilter(Thru& interface, const ThruFilter& filter)
+{
+    bool found = false;
+
+    for (size_t i = 0; i < _thruInterface.size(); i++)
+    {
+        if (_thruInterface.at(i) == &interface)
+        {
+            _thruFilter[i] = filter;
+            found          = true;
+        }
+    }
+
+    return found;
+}
+
+template<typename TransportT>
+void BasicMidi<TransportT>::unregisterThruInterface(Thru& interface)
 {
     for (size_t i = 0; i < _thruInterface.size(); i++)
     {
@@ -974,7 +1772,32 @@ void Base::unregisterThruInterface(Thru& interface)
 }
 
 // return the last decoded midi message
-Message& Base::message()
+template<typename TransportT>
+Message& BasicMidi<TransportT>::message()
 {
     return _message;
-}
\ No newline at end of file
+}
+
+#if MIDI_STATS
+/// Retrieves snapshot of the counters collected since the last call to clearStats().
+template<typename TransportT>
+Stats BasicMidi<TransportT>::stats()
+{
+    return _stats;
+}
+
+/// Sets all the counters to zero.
+template<typename TransportT>
+void BasicMidi<TransportT>::clearStats()
+{
+    _stats = {};
+}
+#endif
+
+namespace lib::midi
+{
+    template class BasicMidi<Transport>;
+    template class BasicMidi<ble::Transport>;
+    template class BasicMidi<serial::Transport>;
+    template class BasicMidi<usb::Transport>;
+}    // namespace lib::midi
\ No newline at end of file
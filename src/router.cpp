@@ -0,0 +1,210 @@
+/*
+    Copyright 2022 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "lib/midi/router.h"
+
+using namespace lib::midi;
+
+/// Adds port to the router.
+/// param port [in]      Port to add.
+/// param worker [in]    Worker which owns the port.
+/// returns: Index of the port used in other calls, or INVALID_PORT if there is no room left.
+size_t Router::addPort(Port& port, size_t worker)
+{
+    if ((_portCount == _ports.size()) || (worker >= MIDI_ROUTER_MAX_WORKERS))
+    {
+        return INVALID_PORT;
+    }
+
+    auto& state = _ports[_portCount];
+
+    state.port   = &port;
+    state.worker = worker;
+    state.routes = 0;
+
+    return _portCount++;
+}
+
+/// Retrieves the amount of added ports.
+size_t Router::ports()
+{
+    return _portCount;
+}
+
+/// Moves port to another worker, for instance after comparing the load of the workers.
+/// param port [in]      Index of the port.
+/// param worker [in]    Worker which should own the port from now on.
+/// returns: True on success, false if the port or worker doesn't exist.
+bool Router::assign(size_t port, size_t worker)
+{
+    if ((port >= _portCount) || (worker >= MIDI_ROUTER_MAX_WORKERS))
+    {
+        return false;
+    }
+
+    _ports[port].worker = worker;
+    return true;
+}
+
+/// Retrieves the worker which owns the port.
+size_t Router::worker(size_t port)
+{
+    return (port < _portCount) ? _ports[port].worker : MIDI_ROUTER_MAX_WORKERS;
+}
+
+/// Forwards all the messages read from the source port to the destination port.
+/// returns: True on success, false if any of the ports doesn't exist.
+bool Router::connect(size_t source, size_t destination)
+{
+    if ((source >= _portCount) || (destination >= _portCount))
+    {
+        return false;
+    }
+
+    _ports[source].routes |= (1ULL << destination);
+    return true;
+}
+
+/// Stops forwarding messages from the source port to the destination port.
+/// returns: True on success, false if any of the ports doesn't exist.
+bool Router::disconnect(size_t source, size_t destination)
+{
+    if ((source >= _portCount) || (destination >= _portCount))
+    {
+        return false;
+    }
+
+    _ports[source].routes &= ~(1ULL << destination);
+    return true;
+}
+
+/// Reads the ports owned by the worker in turn and forwards the messages, then
+/// sends out the messages other workers have queued for the ports owned by this worker.
+/// Every port is read until it has no more data or maxMessages are read from it, so
+/// the messages which remain are handled in the next update.
+/// Must be called for every worker, each one from a single thread.
+/// param worker [in]         Worker to update.
+/// param maxMessages [in]    Maximum amount of messages to read from a single port.
+/// returns: Amount of messages read from the ports and taken over from other workers.
+size_t Router::update(size_t worker, size_t maxMessages)
+{
+    if (worker >= MIDI_ROUTER_MAX_WORKERS)
+    {
+        return 0;
+    }
+
+    size_t  handled = 0;
+    Message message;
+
+    for (size_t i = 0; i < _portCount; i++)
+    {
+        auto& source = _ports[i];
+
+        if (source.worker != worker)
+        {
+            continue;
+        }
+
+        for (size_t count = 0; (count < maxMessages) && source.port->read(message); count++)
+        {
+            source.received.fetch_add(1, std::memory_order_relaxed);
+            handled++;
+
+            if (message.type == messageType_t::SYS_EX)
+            {
+                continue;
+            }
+
+            auto routes = source.routes;
+
+            for (size_t destination = 0; routes; destination++, routes >>= 1)
+            {
+                if (!(routes & 0x01))
+                {
+                    continue;
+                }
+
+                auto& target = _ports[destination];
+
+                if (target.worker == worker)
+                {
+                    deliver(destination, message);
+                    continue;
+                }
+
+                RoutedEvent event;
+                event.event = Event::fromMessage(message);
+                event.port  = static_cast<uint8_t>(destination);
+
+                if (!_queues[(worker * MIDI_ROUTER_MAX_WORKERS) + target.worker].push(event))
+                {
+                    target.dropped.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < MIDI_ROUTER_MAX_WORKERS; i++)
+    {
+        if (i == worker)
+        {
+            continue;
+        }
+
+        auto&       queue = _queues[(i * MIDI_ROUTER_MAX_WORKERS) + worker];
+        RoutedEvent event;
+
+        while (queue.pop(event))
+        {
+            deliver(event.port, event.event.toMessage());
+            handled++;
+        }
+    }
+
+    return handled;
+}
+
+/// Retrieves the traffic counters of the port.
+/// Counters can be read from any thread while the workers are running.
+Router::Load Router::load(size_t port)
+{
+    Load load;
+
+    if (port < _portCount)
+    {
+        load.received = _ports[port].received.load(std::memory_order_relaxed);
+        load.sent     = _ports[port].sent.load(std::memory_order_relaxed);
+        load.dropped  = _ports[port].dropped.load(std::memory_order_relaxed);
+    }
+
+    return load;
+}
+
+void Router::deliver(size_t port, const Message& message)
+{
+    auto& target = _ports[port];
+
+    if (target.port->send(message))
+    {
+        target.sent.fetch_add(1, std::memory_order_relaxed);
+    }
+}
@@ -21,120 +21,468 @@
 
 #include "lib/midi/transport/ble/ble.h"
 
+#include <algorithm>
+#include <cstring>
+
 using namespace lib::midi::ble;
 
-bool Ble::Transport::init()
+namespace
+{
+    /// Range of 13-bit BLE MIDI timestamps.
+    constexpr uint32_t TIMESTAMP_RANGE = 0x2000;
+
+    /// Interval, in units of Hwa::time(), after which the offset between remote
+    /// and local time is increased by one unit when no message arrived earlier than expected.
+    constexpr uint32_t OFFSET_RELAX_INTERVAL = 1000;
+}    // namespace
+
+bool Transport::init()
 {
-    _ble.useRecursiveParsing(true);
-    return _ble._hwa.init();
+    _txBuffer.size   = 0;
+    _timeOffsetValid = false;
+
+    return _hwa.init();
 }
 
-bool Ble::Transport::deInit()
+bool Transport::deInit()
 {
-    return _ble._hwa.deInit();
+    flush();
+    return _hwa.deInit();
 }
 
-bool Ble::Transport::beginTransmission(messageType_t type)
+/// Enables or disables packing of several messages into single packet.
+/// When enabled, messages are collected into the current packet, each one with its own
+/// timestamp and with running status where possible. Packet is sent once the next message
+/// doesn't fit into it, once the specified time has passed since the first message in the
+/// packet was added, or when flush() is called. The time is checked when a new message is
+/// sent and when new packet is read, so read() should be called regularly.
+/// param state [in]       True to enable packing, false to send every message immediately.
+/// param maxLatency [in]  Maximum time, in units of Hwa::time(), for which a message can be kept.
+void Transport::setPacking(bool state, uint32_t maxLatency)
+{
+    flush();
+
+    _packing    = state;
+    _maxLatency = maxLatency;
+}
+
+bool Transport::beginTransmission(messageType_t type)
 {
     // timestamp is 13-bit according to midi ble spec
-    auto time = _ble._hwa.time() & 0x01FFF;
+    const uint32_t TIME      = _hwa.time();
+    const uint8_t  HEADER    = ((TIME & 0x1FFF) >> 7) | 0x80;    // 6 bits plus MSB
+    const uint8_t  TIMESTAMP = (TIME & 0x7F) | 0x80;             // 7 bits plus MSB
+
+    // messages in the same packet share the upper bits of the timestamp
+    if (_txBuffer.size &&
+        ((_txBuffer.data[0] != HEADER) ||
+         ((TIME - _packetTime) >= _maxLatency) ||
+         (_txBuffer.size == _packetSize)))
+    {
+        flush();
+    }
 
-    _txBuffer.data[0] = (time >> 7) | 0x80;      // 6 bits plus MSB
-    _txBuffer.data[1] = (time & 0x7F) | 0x80;    // 7 bits plus MSB
-    _lowTimestamp     = _txBuffer.data[1];
-    _txBuffer.size    = 2;
+    if (!_txBuffer.size)
+    {
+        // MTU can change during the connection, check it for every new packet
+        const size_t MTU = std::max(_hwa.mtu(), Hwa::MIN_MTU);
 
-    return true;
+        _packetSize       = std::min(MTU - Hwa::ATT_HEADER_SIZE, _txBuffer.data.size());
+        _txBuffer.data[0] = HEADER;
+        _txBuffer.size    = 1;
+        _packetTime       = TIME;
+        _txRunningStatus  = 0;
+    }
+
+    _activeType    = type;
+    _lowTimestamp  = TIMESTAMP;
+    _messageStart  = _txBuffer.size;
+    _statusOmitted = false;
+
+    return append(TIMESTAMP);
 }
 
-bool Ble::Transport::write(uint8_t data)
+bool Transport::write(uint8_t data)
 {
-    _txBuffer.data[_txBuffer.size++] = data;
+    if (_packing && (data & 0x80) && (_txBuffer.size == (_messageStart + 1)))
+    {
+        // status byte following the timestamp: skip it if it's the same as in the previous message
+        if (data == _txRunningStatus)
+        {
+            _statusOmitted = true;
+            return true;
+        }
+
+        // only channel messages can use running status
+        _txRunningStatus = (data < 0xF0) ? data : 0;
+    }
+
+    if ((_activeType == messageType_t::SYS_EX) && ((data == 0xF7) || (data >= 0xF8)))
+    {
+        // end of SysEx and Real Time message within SysEx must be preceded by timestamp,
+        // placed in the same packet
+        if (((_txBuffer.size + 2) > _packetSize) && !continuePacket())
+        {
+            return false;
+        }
+
+        // Real Time message gets timestamp of its own
+        const uint8_t TIMESTAMP = (data == 0xF7) ? _lowTimestamp : ((_hwa.time() & 0x7F) | 0x80);
+
+        if (!append(TIMESTAMP))
+        {
+            return false;
+        }
+    }
+
+    return append(data);
+}
 
-    if (_txBuffer.size >= _txBuffer.data.size())
+bool Transport::write(const uint8_t* data, size_t size)
+{
+    if (_activeType != messageType_t::SYS_EX)
     {
-        bool retVal    = _ble._hwa.write(_txBuffer);
-        _txBuffer.size = 1;    // keep header
-        return retVal;
+        return lib::midi::Transport::write(data, size);
+    }
+
+    if (size && (data[size - 1] == 0xF7))
+    {
+        return write(data, size - 1) && write(0xF7);
+    }
+
+    while (size)
+    {
+        if ((_txBuffer.size == _packetSize) && !continuePacket())
+        {
+            return false;
+        }
+
+        const size_t CHUNK = std::min(size, _packetSize - _txBuffer.size);
+
+        memcpy(&_txBuffer.data[_txBuffer.size], data, CHUNK);
+
+        _txBuffer.size += CHUNK;
+        data += CHUNK;
+        size -= CHUNK;
     }
 
     return true;
 }
 
-bool Ble::Transport::endTransmission()
+bool Transport::endTransmission()
 {
-    return _ble._hwa.write(_txBuffer);
+    if (_packing && (_txBuffer.size < _packetSize))
+    {
+        // there might be room for another message
+        return true;
+    }
+
+    return flush();
 }
 
-bool Ble::Transport::read(uint8_t& data)
+/// Sends the packet which is currently being filled, if any.
+bool Transport::flush()
 {
-    if (!_rxIndex)
+    if (!_txBuffer.size)
     {
-        Packet packet;
+        return true;
+    }
 
-        if (!_ble._hwa.read(packet))
+    bool retVal    = _hwa.write(_txBuffer);
+    _txBuffer.size = 0;
+
+    MIDI_STAT(_stats.written(retVal));
+    return retVal;
+}
+
+/// Adds single byte to the packet. If the packet is full, it's sent first.
+bool Transport::append(uint8_t data)
+{
+    if (_txBuffer.size == _packetSize)
+    {
+        if (_packing && (_activeType != messageType_t::SYS_EX) && (_messageStart > 1))
+        {
+            if (!movePacket())
+            {
+                return false;
+            }
+        }
+        else if (!continuePacket())
         {
             return false;
         }
+    }
+
+    _txBuffer.data[_txBuffer.size++] = data;
+    return true;
+}
+
+/// Sends full packet and starts the next one with header only, so that
+/// the message which is being sent continues in the next packet.
+bool Transport::continuePacket()
+{
+    const uint8_t HEADER = _txBuffer.data[0];
+    bool          retVal = flush();
+
+    _txBuffer.data[0] = HEADER;
+    _txBuffer.size    = 1;
+    _messageStart     = 0;
+
+    return retVal;
+}
+
+/// Sends the messages collected so far without the one which is being added
+/// and moves the latter to the start of the next packet.
+bool Transport::movePacket()
+{
+    Packet next = {};
+
+    next.data[next.size++] = _txBuffer.data[0];
+    next.data[next.size++] = _txBuffer.data[_messageStart];
+
+    if (_statusOmitted)
+    {
+        // running status isn't used across packets
+        next.data[next.size++] = _txRunningStatus;
+    }
+
+    for (size_t i = _messageStart + 1; i < _txBuffer.size; i++)
+    {
+        next.data[next.size++] = _txBuffer.data[i];
+    }
+
+    _txBuffer.size = _messageStart;
+
+    bool retVal = flush();
+
+    _txBuffer      = next;
+    _messageStart  = 1;
+    _statusOmitted = false;
+
+    return retVal;
+}
+
+bool Transport::read(uint8_t& data)
+{
+    if (!_rxIndex && !receive())
+    {
+        return false;
+    }
+
+    _readTimestamp = _rxTime[_retrieveIndex];
+    data           = _rxBuffer[_retrieveIndex++];
+
+    if (_retrieveIndex == _rxIndex)
+    {
+        _retrieveIndex = 0;
+        _rxIndex       = 0;
+    }
+
+    return true;
+}
+
+size_t Transport::read(uint8_t* data, size_t size)
+{
+    size_t count = 0;
+
+    while (count < size)
+    {
+        if (!_rxIndex && !receive())
+        {
+            break;
+        }
 
-        if (packet.size > MIDI_BLE_MAX_PACKET_SIZE)
+        const size_t CHUNK = std::min(size - count, _rxIndex - _retrieveIndex);
+
+        memcpy(&data[count], &_rxBuffer[_retrieveIndex], CHUNK);
+
+        count += CHUNK;
+        _retrieveIndex += CHUNK;
+        _readTimestamp = _rxTime[_retrieveIndex - 1];
+
+        if (_retrieveIndex == _rxIndex)
         {
-            return false;
+            _retrieveIndex = 0;
+            _rxIndex       = 0;
         }
+    }
+
+    return count;
+}
+
+bool Transport::receive()
+{
+    if (_packing && _txBuffer.size && ((_hwa.time() - _packetTime) >= _maxLatency))
+    {
+        flush();
+    }
+
+    Packet packet;
+
+    if (!_hwa.read(packet))
+    {
+        return false;
+    }
+
+    if (packet.size > MIDI_BLE_MAX_PACKET_SIZE)
+    {
+        MIDI_STAT(_stats.invalidPackets++);
+        return false;
+    }
+
+    MIDI_STAT(_stats.packetsIn++);
 
-        size_t index           = 0;
-        bool   searchTimestamp = true;
+    const uint32_t TIME            = _hwa.time();
+    const size_t   START           = _rxIndex;
+    uint32_t       high            = packet.data[0] & 0x3F;
+    uint8_t        low             = 0;
+    uint32_t       remote          = high << 7;
+    bool           timestampFound  = false;
+    size_t         index           = 0;
+    bool           searchTimestamp = true;
 
-        // ignore header
-        while (++index < packet.size)
+    // ignore header
+    while (++index < packet.size)
+    {
+        if (searchTimestamp)
         {
-            if (searchTimestamp)
+            if (!(packet.data[index] & 0x80))
             {
-                if (!(packet.data[index] & 0x80))
+                if (index == 1)
                 {
-                    if (index == 1)
-                    {
-                        // sysex continuation, store
-                        _rxBuffer[_rxIndex++] = packet.data[index];
-                    }
-                    else
-                    {
-                        // something is wrong
-                        break;
-                    }
+                    // sysex continuation, store
+                    _rxTime[_rxIndex]     = remote;
+                    _rxBuffer[_rxIndex++] = packet.data[index];
+                }
+                else
+                {
+                    // something is wrong
+                    break;
                 }
-
-                // start filling buffer from the next byte
-                searchTimestamp = false;
             }
             else
             {
-                _rxBuffer[_rxIndex++] = packet.data[index];
+                // lower timestamp bits overflowed within the packet
+                if ((packet.data[index] & 0x7F) < low)
+                {
+                    high++;
+                }
+
+                low            = packet.data[index] & 0x7F;
+                remote         = (high << 7) | low;
+                timestampFound = true;
+            }
+
+            // start filling buffer from the next byte
+            searchTimestamp = false;
+        }
+        else
+        {
+            _rxTime[_rxIndex]     = remote;
+            _rxBuffer[_rxIndex++] = packet.data[index];
 
-                if (index < (packet.size - 1))
+            if (index < (packet.size - 1))
+            {
+                if (packet.data[index + 1] & 0x80)
                 {
-                    if (packet.data[index + 1] & 0x80)
-                    {
-                        // for the next time
-                        searchTimestamp = true;
-                    }
+                    // for the next time
+                    searchTimestamp = true;
                 }
             }
         }
     }
 
-    if (_rxIndex)
+    // timestamps are stored as received until the newest one in the packet is aligned to local time
+    if (timestampFound)
     {
-        data = _rxBuffer[_retrieveIndex++];
+        const uint32_t NEWEST = alignTimestamp(remote & (TIMESTAMP_RANGE - 1), TIME);
 
-        if (_retrieveIndex == _rxIndex)
+        for (size_t i = START; i < _rxIndex; i++)
         {
-            _retrieveIndex = 0;
-            _rxIndex       = 0;
+            _rxTime[i] = NEWEST - (remote - _rxTime[i]);
         }
 
-        return true;
+        _rxTimestamp = NEWEST;
+    }
+    else
+    {
+        // sysex continuation only, keep the last known timestamp
+        for (size_t i = START; i < _rxIndex; i++)
+        {
+            _rxTime[i] = _rxTimestamp;
+        }
+    }
+
+    return _rxIndex != 0;
+}
+
+/// Converts 13-bit timestamp received from the remote device to full-resolution time.
+/// Remote time is expected to run at the same rate as Hwa::time(), with a constant offset.
+/// The smallest observed offset belongs to the message received with the lowest latency:
+/// shifting remote time by it places every message on the local time line, while the
+/// timing between messages sent in the same connection interval is preserved.
+/// Rollover of 13-bit timestamps is resolved by picking the value closest to the
+/// expected remote time. Offset slowly relaxes in order to follow the drift between two clocks.
+/// param timestamp [in]   13-bit timestamp built from packet header and timestamp byte.
+/// param time [in]        Time at which the packet was received.
+/// returns: Time at which the message was sent, in units of Hwa::time().
+uint32_t Transport::alignTimestamp(uint16_t timestamp, uint32_t time)
+{
+    if (!_timeOffsetValid)
+    {
+        _timeOffset      = time - timestamp;
+        _offsetTime      = time;
+        _timeOffsetValid = true;
+    }
+
+    const uint32_t EXPECTED = time - _timeOffset;
+    int32_t        delta    = (timestamp - EXPECTED) & (TIMESTAMP_RANGE - 1);
+
+    if (delta >= static_cast<int32_t>(TIMESTAMP_RANGE / 2))
+    {
+        delta -= TIMESTAMP_RANGE;
     }
 
+    const uint32_t REMOTE = EXPECTED + delta;
+
+    if (delta > 0)
+    {
+        // message arrived with lower latency than any before
+        _timeOffset = time - REMOTE;
+        _offsetTime = time;
+    }
+    else if ((time - _offsetTime) >= OFFSET_RELAX_INTERVAL)
+    {
+        _timeOffset++;
+        _offsetTime = time;
+    }
+
+    return REMOTE + _timeOffset;
+}
+
+/// Retrieves the time at which the last read byte was sent by the remote device,
+/// aligned to Hwa::time().
+uint32_t Transport::timestamp()
+{
+    return _readTimestamp;
+}
+
+/// Waits for Hwa only once all the bytes of the received packet have been read.
+bool Transport::wait(uint32_t& timeout)
+{
+    return _rxIndex || _hwa.wait(timeout);
+}
+
+/// Running status can't be carried across BLE packets and every message is timestamped,
+/// so complete messages are always expected here. Status bytes are omitted by the transport itself when packing is enabled.
+bool Transport::byteStream()
+{
     return false;
-}
\ No newline at end of file
+}
+
+#if MIDI_STATS
+lib::midi::TransportStats Transport::stats()
+{
+    return _stats;
+}
+#endif
\ No newline at end of file
@@ -21,48 +21,128 @@
 
 #include "lib/midi/transport/serial/serial.h"
 
+#include <algorithm>
+#include <cstring>
+
 using namespace lib::midi::serial;
 
-bool Serial::Transport::init()
+bool Transport::init()
+{
+    _rxIndex = 0;
+    _rxCount = 0;
+    _txCount = 0;
+
+    return _hwa.init();
+}
+
+bool Transport::deInit()
 {
-    _serial.useRecursiveParsing(true);
-    return _serial._hwa.init();
+    return _hwa.deInit();
 }
 
-bool Serial::Transport::deInit()
+bool Transport::beginTransmission(messageType_t)
 {
-    return _serial._hwa.deInit();
+    _txCount = 0;
+    return true;
 }
 
-bool Serial::Transport::beginTransmission(messageType_t type)
+/// Stages single byte of the message, so that the entire message
+/// is passed to Hwa at once in endTransmission().
+bool Transport::write(uint8_t data)
 {
-    // nothing to do
+    if ((_txCount == _txBuffer.size()) && !writeStaged())
+    {
+        return false;
+    }
+
+    _txBuffer[_txCount++] = data;
     return true;
 }
 
-bool Serial::Transport::write(uint8_t data)
+bool Transport::write(const uint8_t* data, size_t size)
 {
-    Packet packet = { data };
+    if (!writeStaged())
+    {
+        return false;
+    }
+
+    bool retVal = _hwa.write(data, size);
+
+    MIDI_STAT(_stats.written(retVal, size));
+    return retVal;
+}
 
-    return _serial._hwa.write(packet);
+bool Transport::endTransmission()
+{
+    return writeStaged();
 }
 
-bool Serial::Transport::endTransmission()
+/// Reads single byte from the local buffer, which is refilled with
+/// a single block read from Hwa once empty. This way, the parser consumes
+/// contiguous spans of received data instead of calling Hwa for every byte.
+bool Transport::read(uint8_t& data)
 {
-    // nothing to do
+    if (_rxIndex == _rxCount)
+    {
+        _rxIndex = 0;
+        _rxCount = _hwa.read(_rxBuffer.data(), _rxBuffer.size());
+
+        MIDI_STAT(_stats.packetsIn += _rxCount);
+
+        if (!_rxCount)
+        {
+            return false;
+        }
+    }
+
+    data = _rxBuffer[_rxIndex++];
     return true;
 }
 
-bool Serial::Transport::read(uint8_t& data)
+size_t Transport::read(uint8_t* data, size_t size)
 {
-    Packet packet = {};
+    // bytes already retrieved from Hwa come first
+    size_t count = std::min(size, _rxCount - _rxIndex);
+
+    memcpy(data, &_rxBuffer[_rxIndex], count);
+    _rxIndex += count;
 
-    if (!_serial._hwa.read(packet))
+    if (count < size)
     {
-        return false;
+        const size_t READ = _hwa.read(&data[count], size - count);
+
+        MIDI_STAT(_stats.packetsIn += READ);
+        count += READ;
     }
 
-    data = packet.data;
+    return count;
+}
 
-    return true;
-}
\ No newline at end of file
+/// Waits for Hwa only once all the bytes retrieved from it have been read.
+bool Transport::wait(uint32_t& timeout)
+{
+    return (_rxIndex != _rxCount) || _hwa.wait(timeout);
+}
+
+/// Passes all staged bytes to Hwa.
+bool Transport::writeStaged()
+{
+    if (!_txCount)
+    {
+        return true;
+    }
+
+    bool retVal = _hwa.write(_txBuffer.data(), _txCount);
+
+    MIDI_STAT(_stats.written(retVal, _txCount));
+    _txCount = 0;
+
+    return retVal;
+}
+
+#if MIDI_STATS
+lib::midi::TransportStats Transport::stats()
+{
+    return _stats;
+}
+#endif
\ No newline at end of file
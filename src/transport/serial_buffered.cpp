@@ -0,0 +1,87 @@
+/*
+    Copyright 2022 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "lib/midi/transport/serial/buffered.h"
+
+using namespace lib::midi::serial;
+
+bool BufferedHwa::write(Packet& packet)
+{
+    return write(&packet.data, 1);
+}
+
+bool BufferedHwa::read(Packet& packet)
+{
+    return _rxBuffer.pop(packet.data);
+}
+
+/// Queues block of data for transmission.
+/// When the data doesn't fit into the transmit buffer, this waits for the
+/// buffer to be drained, in the same way as blocking UART driver would.
+/// Transmission is started before waiting so that the buffer gets drained even if
+/// nothing could be queued. Must not be called from the context which drains the transmit buffer.
+/// returns: False if the buffer wasn't drained within MIDI_SERIAL_TX_RETRIES attempts, in which
+///          case only part of the data might have been queued.
+bool BufferedHwa::write(const uint8_t* data, size_t size)
+{
+    size_t count   = 0;
+    size_t retries = 0;
+
+    while (count < size)
+    {
+        const size_t WRITTEN = _txBuffer.write(&data[count], size - count);
+
+        if (WRITTEN)
+        {
+            count += WRITTEN;
+            retries = 0;
+            startTransmission();
+        }
+        else if (!retries++)
+        {
+            // buffer is full: make sure it's being drained, even if nothing was queued by this call
+            startTransmission();
+        }
+        else if (retries > MIDI_SERIAL_TX_RETRIES)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+size_t BufferedHwa::read(uint8_t* data, size_t size)
+{
+    return _rxBuffer.read(data, size);
+}
+
+/// Retrieves receive buffer, to be filled by interrupt routine or DMA.
+BufferedHwa::RxBuffer& BufferedHwa::rxBuffer()
+{
+    return _rxBuffer;
+}
+
+/// Retrieves transmit buffer, to be drained by interrupt routine or DMA.
+BufferedHwa::TxBuffer& BufferedHwa::txBuffer()
+{
+    return _txBuffer;
+}
@@ -23,21 +23,85 @@
 
 using namespace lib::midi::usb;
 
-bool Usb::Transport::init()
+namespace
 {
-    _txIndex = 0;
-    _rxIndex = 0;
-    _usb.useRecursiveParsing(true);
+    /// Describes status bytes of the messages which can be decoded directly from USB MIDI packet.
+    /// Lower nibble holds Code Index Number with which the message must be sent,
+    /// upper nibble holds the length of the message.
+    constexpr uint8_t eventInfo(uint8_t status)
+    {
+        switch (lib::midi::TYPE_FROM_STATUS_BYTE(status))
+        {
+        case lib::midi::messageType_t::PROGRAM_CHANGE:
+        case lib::midi::messageType_t::AFTER_TOUCH_CHANNEL:
+            return 0x20 | (status >> 4);
+
+        case lib::midi::messageType_t::NOTE_ON:
+        case lib::midi::messageType_t::NOTE_OFF:
+        case lib::midi::messageType_t::CONTROL_CHANGE:
+        case lib::midi::messageType_t::PITCH_BEND:
+        case lib::midi::messageType_t::AFTER_TOUCH_POLY:
+            return 0x30 | (status >> 4);
+
+        case lib::midi::messageType_t::SYS_COMMON_TIME_CODE_QUARTER_FRAME:
+        case lib::midi::messageType_t::SYS_COMMON_SONG_SELECT:
+            return 0x22;
+
+        case lib::midi::messageType_t::SYS_COMMON_SONG_POSITION:
+            return 0x33;
+
+        case lib::midi::messageType_t::SYS_COMMON_TUNE_REQUEST:
+            return 0x15;
+
+        case lib::midi::messageType_t::SYS_REAL_TIME_CLOCK:
+        case lib::midi::messageType_t::SYS_REAL_TIME_START:
+        case lib::midi::messageType_t::SYS_REAL_TIME_CONTINUE:
+        case lib::midi::messageType_t::SYS_REAL_TIME_STOP:
+        case lib::midi::messageType_t::SYS_REAL_TIME_ACTIVE_SENSING:
+        case lib::midi::messageType_t::SYS_REAL_TIME_SYSTEM_RESET:
+            return 0x1F;
+
+        default:
+            return 0;
+        }
+    }
 
-    return _usb._hwa.init();
+    constexpr std::array<uint8_t, 256> makeEventTable()
+    {
+        std::array<uint8_t, 256> table = {};
+
+        for (size_t i = 0x80; i < table.size(); i++)
+        {
+            table[i] = eventInfo(i);
+        }
+
+        return table;
+    }
+
+    /// Lookup table indexed with the first data byte of USB MIDI packet.
+    /// Data bytes, SysEx and undefined status bytes are set to 0.
+    constexpr std::array<uint8_t, 256> EVENT_TABLE = makeEventTable();
+}    // namespace
+
+bool Transport::init()
+{
+    _txIndex       = 0;
+    _txPacketCount = 0;
+    _rxIndex       = 0;
+    _rxCount       = 0;
+    _rxPacketIndex = 0;
+    _rxPacketCount = 0;
+
+    return _hwa.init();
 }
 
-bool Usb::Transport::deInit()
+bool Transport::deInit()
 {
-    return _usb._hwa.deInit();
+    flush();
+    return _hwa.deInit();
 }
 
-bool Usb::Transport::beginTransmission(messageType_t type)
+bool Transport::beginTransmission(messageType_t type)
 {
     _activeType                       = type;
     _txBuffer.data[Packet::USB_EVENT] = usbMIDIHeader(CIN, static_cast<uint8_t>(type));
@@ -46,7 +110,7 @@ bool Usb::Transport::beginTransmission(messageType_t type)
     return true;
 }
 
-bool Usb::Transport::write(uint8_t data)
+bool Transport::write(uint8_t data)
 {
     bool returnValue = true;
 
@@ -54,6 +118,17 @@ bool Usb::Transport::write(uint8_t data)
     {
         _txBuffer.data[_txIndex + 1] = data;
     }
+    else if (data >= 0xF8)
+    {
+        // Real Time message within SysEx is sent in its own packet,
+        // SysEx bytes collected so far continue in the next one
+        Packet packet = {};
+
+        packet.data[Packet::USB_EVENT] = usbMIDIHeader(CIN, data);
+        packet.data[Packet::USB_DATA1] = data;
+
+        return writePacket(packet);
+    }
     else if (data == 0xF0)
     {
         // start of sysex
@@ -111,78 +186,282 @@ bool Usb::Transport::write(uint8_t data)
     return returnValue;
 }
 
-bool Usb::Transport::endTransmission()
-{
-    return _usb._hwa.write(_txBuffer);
-}
-
-bool Usb::Transport::read(uint8_t& data)
+bool Transport::write(const uint8_t* data, size_t size)
 {
-    if (!_rxIndex)
+    if (_activeType != messageType_t::SYS_EX)
     {
-        Packet packet = {};
+        return lib::midi::Transport::write(data, size);
+    }
+
+    // SysEx start and end are handled byte by byte, everything in between
+    // is packed directly into the packets three bytes at a time
+    size_t i = 0;
 
-        if (!_usb._hwa.read(packet))
+    while ((i < size) && ((data[i] == 0xF0) || (_txIndex % 3)))
+    {
+        if (!Transport::write(data[i++]))
         {
             return false;
         }
+    }
 
-        // We already have entire message here.
-        // MIDIEvent.Event is CIN, see midi10.pdf.
-        // Shift CIN four bytes left to get messageType_t.
-        uint8_t midiMessage = packet.data[Packet::USB_EVENT] << 4;
+    while (((size - i) > 3) || (((size - i) == 3) && (data[size - 1] != 0xF7)))
+    {
+        _txBuffer.data[Packet::USB_EVENT] = usbMIDIHeader(CIN, static_cast<uint8_t>(systemEvent_t::SYS_EX_START));
+        _txBuffer.data[Packet::USB_DATA1] = data[i++];
+        _txBuffer.data[Packet::USB_DATA2] = data[i++];
+        _txBuffer.data[Packet::USB_DATA3] = data[i++];
+        _txIndex += 3;
 
-        switch (midiMessage)
+        if (!endTransmission())
         {
-        // 1 byte messages
-        case static_cast<uint8_t>(systemEvent_t::SYS_COMMON1BYTE):
-        case static_cast<uint8_t>(systemEvent_t::SINGLE_BYTE):
+            return false;
+        }
+    }
+
+    while (i < size)
+    {
+        if (!Transport::write(data[i++]))
         {
-            _rxBuffer[_rxIndex++] = packet.data[Packet::USB_DATA1];
+            return false;
         }
-        break;
+    }
+
+    return true;
+}
+
+bool Transport::endTransmission()
+{
+    return writePacket(_txBuffer);
+}
+
+/// Writes the packet directly to Hwa or adds it to the collected ones,
+/// depending on MIDI_USB_TX_PACKETS.
+bool Transport::writePacket(Packet& packet)
+{
+    if constexpr (MIDI_USB_TX_PACKETS == 1)
+    {
+        bool retVal = _hwa.write(packet);
+
+        MIDI_STAT(_stats.written(retVal));
+        return retVal;
+    }
+
+    _txPackets[_txPacketCount++] = packet;
+
+    if (_txPacketCount == _txPackets.size())
+    {
+        return writeStaged();
+    }
+
+    return true;
+}
+
+/// Writes all the collected packets to Hwa at once, and lets Hwa write out
+/// the packets it collects on its own, such as usb::Multiplexer.
+bool Transport::flush()
+{
+    bool retVal = writeStaged();
+    return _hwa.flush() && retVal;
+}
+
+/// Writes all the collected packets to Hwa at once.
+/// Packets are discarded if Hwa fails to write them.
+bool Transport::writeStaged()
+{
+    if (!_txPacketCount)
+    {
+        return true;
+    }
+
+    bool retVal = _hwa.write(_txPackets.data(), _txPacketCount);
+
+    MIDI_STAT(_stats.written(retVal, _txPacketCount));
+
+    _txPacketCount = 0;
+    return retVal;
+}
+
+/// Every USB MIDI packet must hold the complete message, or part of SysEx message.
+bool Transport::byteStream()
+{
+    return false;
+}
 
-        // 2 byte messages
-        case static_cast<uint8_t>(systemEvent_t::SYS_COMMON2BYTE):
-        case static_cast<uint8_t>(messageType_t::PROGRAM_CHANGE):
-        case static_cast<uint8_t>(messageType_t::AFTER_TOUCH_CHANNEL):
-        case static_cast<uint8_t>(messageType_t::SYS_COMMON_TIME_CODE_QUARTER_FRAME):
-        case static_cast<uint8_t>(messageType_t::SYS_COMMON_SONG_SELECT):
-        case static_cast<uint8_t>(systemEvent_t::SYS_EX_STOP2BYTE):
+bool Transport::read(uint8_t& data)
+{
+    if ((_rxIndex == _rxCount) && !receive())
+    {
+        return false;
+    }
+
+    data = _rxBuffer[_rxIndex++];
+
+    return true;
+}
+
+size_t Transport::read(uint8_t* data, size_t size)
+{
+    size_t count = 0;
+
+    while (count < size)
+    {
+        if ((_rxIndex == _rxCount) && !receive())
         {
-            _rxBuffer[_rxIndex++] = packet.data[Packet::USB_DATA2];
-            _rxBuffer[_rxIndex++] = packet.data[Packet::USB_DATA1];
+            break;
         }
-        break;
 
-        // 3 byte messages
-        case static_cast<uint8_t>(messageType_t::NOTE_ON):
-        case static_cast<uint8_t>(messageType_t::NOTE_OFF):
-        case static_cast<uint8_t>(messageType_t::CONTROL_CHANGE):
-        case static_cast<uint8_t>(messageType_t::PITCH_BEND):
-        case static_cast<uint8_t>(messageType_t::AFTER_TOUCH_POLY):
-        case static_cast<uint8_t>(messageType_t::SYS_COMMON_SONG_POSITION):
-        case static_cast<uint8_t>(systemEvent_t::SYS_EX_START):
-        case static_cast<uint8_t>(systemEvent_t::SYS_EX_STOP3BYTE):
+        while ((count < size) && (_rxIndex < _rxCount))
         {
-            _rxBuffer[_rxIndex++] = packet.data[Packet::USB_DATA3];
-            _rxBuffer[_rxIndex++] = packet.data[Packet::USB_DATA2];
-            _rxBuffer[_rxIndex++] = packet.data[Packet::USB_DATA1];
+            data[count++] = _rxBuffer[_rxIndex++];
         }
-        break;
+    }
 
-        default:
-            return false;
+    return count;
+}
+
+/// Waits for Hwa only once all the packets retrieved from it have been read.
+bool Transport::wait(uint32_t& timeout)
+{
+    return (_rxIndex != _rxCount) || (_rxPacketIndex != _rxPacketCount) || _hwa.wait(timeout);
+}
+
+/// Decodes received packet into message without passing its bytes through the parser.
+/// SysEx and malformed packets are stored and have to be retrieved with read().
+lib::midi::readResult_t Transport::readMessage(Message& message)
+{
+    if (_rxIndex != _rxCount)
+    {
+        // bytes of the previous packet haven't been read yet
+        return readResult_t::RAW;
+    }
+
+    auto packet = nextPacket();
+
+    if (packet == nullptr)
+    {
+        return readResult_t::NO_DATA;
+    }
+
+    const uint8_t STATUS = packet->data[Packet::USB_DATA1];
+    const uint8_t INFO   = EVENT_TABLE[STATUS];
+
+    if (!INFO || ((INFO & 0x0F) != (packet->data[Packet::USB_EVENT] & 0x0F)))
+    {
+        load(*packet);
+        return readResult_t::RAW;
+    }
+
+    const uint8_t LENGTH = INFO >> 4;
+
+    message.type    = TYPE_FROM_STATUS_BYTE(STATUS);
+    message.channel = (STATUS < 0xF0) ? CHANNEL_FROM_STATUS_BYTE(STATUS) : 0;
+    message.data1   = (LENGTH > 1) ? (packet->data[Packet::USB_DATA2] & 0x7F) : 0;
+    message.data2   = (LENGTH > 2) ? (packet->data[Packet::USB_DATA3] & 0x7F) : 0;
+    message.length  = LENGTH;
+    message.valid   = true;
+
+    return readResult_t::MESSAGE;
+}
+
+/// Retrieves next received packet. Packets are read from Hwa in blocks of up to MIDI_USB_RX_PACKETS.
+/// returns: Pointer to the packet, valid until the next call, or nullptr if nothing was received.
+const Packet* Transport::nextPacket()
+{
+    if (_rxPacketIndex == _rxPacketCount)
+    {
+        _rxPacketIndex = 0;
+        _rxPacketCount = _hwa.read(_rxPackets.data(), _rxPackets.size());
+
+        MIDI_STAT(_stats.packetsIn += _rxPacketCount);
+
+        if (!_rxPacketCount)
+        {
+            return nullptr;
         }
     }
 
-    if (_rxIndex)
+    return &_rxPackets[_rxPacketIndex++];
+}
+
+bool Transport::receive()
+{
+    auto packet = nextPacket();
+
+    if (packet == nullptr)
     {
-        data = _rxBuffer[_rxIndex - 1];
-        _rxIndex--;
+        return false;
+    }
 
-        return true;
+    return load(*packet);
+}
+
+/// Stores bytes of the received packet so that they can be retrieved with read().
+bool Transport::load(const Packet& packet)
+{
+    _rxIndex = 0;
+    _rxCount = 0;
+
+    // We already have entire message here.
+    // MIDIEvent.Event is CIN, see midi10.pdf.
+    // Shift CIN four bytes left to get messageType_t.
+    uint8_t midiMessage = packet.data[Packet::USB_EVENT] << 4;
+
+    switch (midiMessage)
+    {
+    // 1 byte messages
+    case static_cast<uint8_t>(systemEvent_t::SYS_COMMON1BYTE):
+    case static_cast<uint8_t>(systemEvent_t::SINGLE_BYTE):
+    {
+        _rxCount = 1;
+    }
+    break;
+
+    // 2 byte messages
+    case static_cast<uint8_t>(systemEvent_t::SYS_COMMON2BYTE):
+    case static_cast<uint8_t>(messageType_t::PROGRAM_CHANGE):
+    case static_cast<uint8_t>(messageType_t::AFTER_TOUCH_CHANNEL):
+    case static_cast<uint8_t>(messageType_t::SYS_COMMON_TIME_CODE_QUARTER_FRAME):
+    case static_cast<uint8_t>(messageType_t::SYS_COMMON_SONG_SELECT):
+    case static_cast<uint8_t>(systemEvent_t::SYS_EX_STOP2BYTE):
+    {
+        _rxCount = 2;
+    }
+    break;
+
+    // 3 byte messages
+    case static_cast<uint8_t>(systemEvent_t::SYS_COMMON3BYTE):
+    case static_cast<uint8_t>(messageType_t::NOTE_ON):
+    case static_cast<uint8_t>(messageType_t::NOTE_OFF):
+    case static_cast<uint8_t>(messageType_t::CONTROL_CHANGE):
+    case static_cast<uint8_t>(messageType_t::PITCH_BEND):
+    case static_cast<uint8_t>(messageType_t::AFTER_TOUCH_POLY):
+    case static_cast<uint8_t>(messageType_t::SYS_COMMON_SONG_POSITION):
+    case static_cast<uint8_t>(systemEvent_t::SYS_EX_START):
+    case static_cast<uint8_t>(systemEvent_t::SYS_EX_STOP3BYTE):
+    {
+        _rxCount = 3;
     }
+    break;
 
-    return false;
-}
\ No newline at end of file
+    default:
+    {
+        MIDI_STAT(_stats.invalidPackets++);
+        return false;
+    }
+    }
+
+    for (size_t i = 0; i < _rxCount; i++)
+    {
+        _rxBuffer[i] = packet.data[Packet::USB_DATA1 + i];
+    }
+
+    return true;
+}
+
+#if MIDI_STATS
+lib::midi::TransportStats Transport::stats()
+{
+    return _stats;
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,265 @@
+/*
+    Copyright 2022 Igor Petrovic
+
+    Permission is hereby granted, free of charge, to any person obtaining
+    a copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+    sell copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+    OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "lib/midi/transport/usb/multiplexer.h"
+
+using namespace lib::midi::usb;
+
+Multiplexer::Multiplexer(Hwa& hwa)
+    : _hwa(hwa)
+{
+    for (size_t i = 0; i < _cables.size(); i++)
+    {
+        _cables[i]._multiplexer = this;
+        _cables[i]._index       = i;
+    }
+}
+
+/// Retrieves Hwa interface of the specified virtual cable.
+/// param index [in]   Cable number, must be lower than MIDI_USB_CABLES.
+Multiplexer::Cable& Multiplexer::cable(uint8_t index)
+{
+    return _cables[index];
+}
+
+#if MIDI_STATS
+/// Retrieves the amount of received packets which were dropped because
+/// their cable wasn't initialized.
+uint32_t Multiplexer::dropped()
+{
+    return _dropped;
+}
+#endif
+
+/// Writes packets collected from all the cables to the endpoint at once.
+/// Packets are discarded if Hwa fails to write them.
+bool Multiplexer::flush()
+{
+    if (!_txPacketCount)
+    {
+        return true;
+    }
+
+    bool retVal = _hwa.write(_txPackets.data(), _txPacketCount);
+
+    _txPacketCount = 0;
+    return retVal;
+}
+
+/// Endpoint is initialized together with the first cable.
+bool Multiplexer::init()
+{
+    if (_initCount++)
+    {
+        return true;
+    }
+
+    _txPacketCount = 0;
+    _rxPacketIndex = 0;
+    _rxPacketCount = 0;
+
+    for (auto& cable : _cables)
+    {
+        cable._rxHead  = 0;
+        cable._rxCount = 0;
+    }
+
+    return _hwa.init();
+}
+
+/// Endpoint is deinitialized together with the last cable.
+bool Multiplexer::deInit()
+{
+    if (!_initCount)
+    {
+        return true;
+    }
+
+    if (--_initCount)
+    {
+        return flush();
+    }
+
+    flush();
+    return _hwa.deInit();
+}
+
+bool Multiplexer::write(uint8_t cable, const Packet* packets, size_t count)
+{
+    bool retVal = true;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        // cable number is set here so that it always matches the cable used to send the packet
+        auto& packet = _txPackets[_txPacketCount++];
+
+        packet                         = packets[i];
+        packet.data[Packet::USB_EVENT] = (cable << 4) | (packet.data[Packet::USB_EVENT] & 0x0F);
+
+        if (_txPacketCount == _txPackets.size())
+        {
+            retVal &= flush();
+        }
+    }
+
+    return retVal;
+}
+
+/// Routes received packets to the cables, reading the endpoint once all the
+/// previously received packets have been routed.
+/// Packet is dropped if its cable isn't initialized. If the queue of the cable is full,
+/// the packet and the ones after it are kept until that cable is read.
+void Multiplexer::receive()
+{
+    if (!pending())
+    {
+        _rxPacketIndex = 0;
+        _rxPacketCount = _hwa.read(_rxPackets.data(), _rxPackets.size());
+    }
+
+    while (pending())
+    {
+        const auto& PACKET = _rxPackets[_rxPacketIndex];
+        const auto  CABLE  = static_cast<size_t>(PACKET.data[Packet::USB_EVENT] >> 4);
+
+        if ((CABLE >= _cables.size()) || !_cables[CABLE]._active)
+        {
+            MIDI_STAT(_dropped++);
+        }
+        else if (!_cables[CABLE].push(PACKET))
+        {
+            return;
+        }
+
+        _rxPacketIndex++;
+    }
+}
+
+/// Checks whether some of the received packets haven't been routed yet.
+bool Multiplexer::pending()
+{
+    return _rxPacketIndex != _rxPacketCount;
+}
+
+bool Multiplexer::wait(uint32_t& timeout)
+{
+    return _hwa.wait(timeout);
+}
+
+bool Multiplexer::Cable::init()
+{
+    _active = true;
+    return _multiplexer->init();
+}
+
+bool Multiplexer::Cable::deInit()
+{
+    _active  = false;
+    _rxHead  = 0;
+    _rxCount = 0;
+
+    return _multiplexer->deInit();
+}
+
+bool Multiplexer::Cable::write(Packet& packet)
+{
+    return _multiplexer->write(_index, &packet, 1);
+}
+
+bool Multiplexer::Cable::write(const Packet* packets, size_t count)
+{
+    return _multiplexer->write(_index, packets, count);
+}
+
+/// Writes out the packets collected from all the cables.
+bool Multiplexer::Cable::flush()
+{
+    return _multiplexer->flush();
+}
+
+bool Multiplexer::Cable::read(Packet& packet)
+{
+    return read(&packet, 1) == 1;
+}
+
+size_t Multiplexer::Cable::read(Packet* packets, size_t count)
+{
+    if (!_rxCount)
+    {
+        _multiplexer->receive();
+    }
+
+    size_t index = 0;
+
+    while ((index < count) && _rxCount)
+    {
+        packets[index++] = _rxPackets[_rxHead++];
+        _rxCount--;
+
+        if (_rxHead == _rxPackets.size())
+        {
+            _rxHead = 0;
+        }
+    }
+
+    return index;
+}
+
+/// Waits for the endpoint shared by all the cables: it may also return when
+/// packets for other cables are received. Returns false at once if the received packets
+/// are held back until another cable is read, since the endpoint isn't read in the meantime.
+bool Multiplexer::Cable::wait(uint32_t& timeout)
+{
+    if (!_rxCount)
+    {
+        _multiplexer->receive();
+    }
+
+    if (_rxCount)
+    {
+        return true;
+    }
+
+    return !_multiplexer->pending() && _multiplexer->wait(timeout);
+}
+
+/// Stores packet routed to this cable.
+/// returns: False if there is no room left for the packet.
+bool Multiplexer::Cable::push(const Packet& packet)
+{
+    if (_rxCount == _rxPackets.size())
+    {
+        return false;
+    }
+
+    auto index = _rxHead + _rxCount;
+
+    if (index >= _rxPackets.size())
+    {
+        index -= _rxPackets.size();
+    }
+
+    _rxPackets[index] = packet;
+    _rxCount++;
+
+    return true;
+}
@@ -53,11 +53,18 @@ namespace
 
             uint32_t time() override
             {
-                return 0x80;
+                return _time;
+            }
+
+            size_t mtu() override
+            {
+                return _mtu;
             }
 
             std::vector<Packet> _writePackets = {};
             std::vector<Packet> _readPackets  = {};
+            size_t              _mtu          = MIDI_BLE_MAX_PACKET_SIZE + ATT_HEADER_SIZE;
+            uint32_t            _time         = 0x80;
         };
 
         BleHwa _hwa;
@@ -328,4 +335,238 @@ TEST_F(BleMidiTest, ReadSysEx3Packet)
 
     ASSERT_TRUE(_ble.read());
     EXPECT_EQ(messageType_t::SYS_EX, _ble.message().type);
-}
\ No newline at end of file
+}
+
+TEST_F(BleMidiTest, ReadAllMessagesInPacket)
+{
+    Packet packet = {};
+
+    packet.data.at(packet.size++) = 0x80;    // header
+    packet.data.at(packet.size++) = 0x80;    // timestamp
+    packet.data.at(packet.size++) = 0x90;    // note on
+    packet.data.at(packet.size++) = 0x00;    // note index
+    packet.data.at(packet.size++) = 0x7F;    // velocity
+    packet.data.at(packet.size++) = 0x80;    // timestamp
+    packet.data.at(packet.size++) = 0xF8;    // clock
+    packet.data.at(packet.size++) = 0x80;    // timestamp
+    packet.data.at(packet.size++) = 0xB1;    // control change
+    packet.data.at(packet.size++) = 0x07;    // controller
+    packet.data.at(packet.size++) = 0x40;    // value
+
+    _hwa._readPackets.push_back(packet);
+
+    ASSERT_EQ(3, _ble.readAll());
+    ASSERT_EQ(3, _ble.queued());
+    EXPECT_EQ(messageType_t::NOTE_ON, _ble.queuedMessage(0).type);
+    EXPECT_EQ(messageType_t::SYS_REAL_TIME_CLOCK, _ble.queuedMessage(1).type);
+    EXPECT_EQ(messageType_t::CONTROL_CHANGE, _ble.queuedMessage(2).type);
+    EXPECT_EQ(2, _ble.queuedMessage(2).channel);
+
+    Message message;
+
+    ASSERT_TRUE(_ble.pop(message));
+    EXPECT_EQ(messageType_t::NOTE_ON, message.type);
+    EXPECT_EQ(2, _ble.queued());
+
+    _hwa._readPackets.push_back(packet);
+
+    // only two slots are free
+    ASSERT_EQ(2, _ble.readAll());
+    EXPECT_EQ(messageType_t::SYS_REAL_TIME_CLOCK, _ble.queuedMessage(0).type);
+    EXPECT_EQ(messageType_t::NOTE_ON, _ble.queuedMessage(2).type);
+    EXPECT_EQ(messageType_t::SYS_REAL_TIME_CLOCK, _ble.queuedMessage(3).type);
+
+    _ble.clearQueue();
+    EXPECT_EQ(0, _ble.queued());
+    ASSERT_FALSE(_ble.pop(message));
+}
+
+TEST_F(BleMidiTest, PackMessages)
+{
+    _ble.transport().setPacking(true, 10);
+
+    ASSERT_TRUE(_ble.sendControlChange(7, 1, 1));
+    ASSERT_TRUE(_ble.sendControlChange(7, 2, 1));
+    ASSERT_TRUE(_ble.sendControlChange(7, 3, 1));
+    ASSERT_TRUE(_ble.sendNoteOn(60, 127, 1));
+    ASSERT_TRUE(_ble.sendRealTime(messageType_t::SYS_REAL_TIME_CLOCK));
+    ASSERT_TRUE(_ble.sendSysEx(3, std::array<uint8_t, 3>{ 0x01, 0x02, 0x03 }.data(), false));
+
+    EXPECT_EQ(0, _hwa._writePackets.size());
+    ASSERT_TRUE(_ble.flush());
+    ASSERT_EQ(1, _hwa._writePackets.size());
+
+    const std::vector<uint8_t> EXPECTED = {
+        0x81,    // header
+        0x80,
+        0xB0,
+        0x07,
+        0x01,
+        0x80,    // running status
+        0x07,
+        0x02,
+        0x80,
+        0x07,
+        0x03,
+        0x80,
+        0x90,
+        0x3C,
+        0x7F,
+        0x80,
+        0xF8,
+        0x80,
+        0xF0,
+        0x01,
+        0x02,
+        0x03,
+        0x80,    // timestamp before end of sysex
+        0xF7,
+    };
+
+    auto packet = _hwa._writePackets.at(0);
+
+    EXPECT_EQ(EXPECTED, std::vector<uint8_t>(packet.data.begin(), packet.data.begin() + packet.size));
+
+    // packed messages are decoded in the same order
+    _hwa._readPackets.push_back(packet);
+
+    const std::vector<messageType_t> EXPECTED_TYPES = {
+        messageType_t::CONTROL_CHANGE,
+        messageType_t::CONTROL_CHANGE,
+        messageType_t::CONTROL_CHANGE,
+        messageType_t::NOTE_ON,
+        messageType_t::SYS_REAL_TIME_CLOCK,
+        messageType_t::SYS_EX,
+    };
+
+    for (size_t i = 0; i < EXPECTED_TYPES.size(); i++)
+    {
+        ASSERT_TRUE(_ble.read());
+        EXPECT_EQ(EXPECTED_TYPES.at(i), _ble.type());
+    }
+
+    EXPECT_EQ(5, _ble.length());
+}
+
+TEST_F(BleMidiTest, PackMessagesOverflow)
+{
+    _ble.transport().setPacking(true, 10);
+
+    // fill the packet so that the last message doesn't fit
+    const size_t MESSAGES = (MIDI_BLE_MAX_PACKET_SIZE - 1) / 3;
+
+    for (size_t i = 0; i < MESSAGES + 1; i++)
+    {
+        ASSERT_TRUE(_ble.sendControlChange(7, i, 1));
+    }
+
+    ASSERT_EQ(1, _hwa._writePackets.size());
+    ASSERT_TRUE(_ble.flush());
+    ASSERT_EQ(2, _hwa._writePackets.size());
+
+    // running status isn't used at the start of the next packet
+    auto packet = _hwa._writePackets.at(1);
+    EXPECT_EQ(0xB0, packet.data.at(2));
+
+    _hwa._readPackets = _hwa._writePackets;
+
+    for (size_t i = 0; i < MESSAGES + 1; i++)
+    {
+        ASSERT_TRUE(_ble.read());
+        EXPECT_EQ(i, _ble.data2());
+    }
+
+    ASSERT_FALSE(_ble.read());
+}
+
+TEST_F(BleMidiTest, PacketSizeFollowsMtu)
+{
+    std::array<uint8_t, 40> sysEx = {};
+
+    _hwa._mtu = Hwa::MIN_MTU;
+    ASSERT_TRUE(_ble.sendSysEx(sysEx.size(), sysEx.data(), false));
+
+    // 20 bytes of payload per packet: 42 bytes of sysex, 2 timestamps and a header in every packet
+    ASSERT_EQ(3, _hwa._writePackets.size());
+
+    for (const auto& packet : _hwa._writePackets)
+    {
+        EXPECT_LE(packet.size, Hwa::MIN_MTU - Hwa::ATT_HEADER_SIZE);
+    }
+
+    _hwa._readPackets = _hwa._writePackets;
+
+    ASSERT_TRUE(_ble.read());
+    EXPECT_EQ(messageType_t::SYS_EX, _ble.type());
+    EXPECT_EQ(sysEx.size() + 2, _ble.length());
+
+    // larger MTU is used for the next packet, up to MIDI_BLE_MAX_PACKET_SIZE
+    _hwa._writePackets.clear();
+    _hwa._mtu = 1024;
+    ASSERT_TRUE(_ble.sendSysEx(sysEx.size(), sysEx.data(), false));
+    ASSERT_EQ(1, _hwa._writePackets.size());
+}
+
+TEST_F(BleMidiTest, ReceiveTimestamps)
+{
+    _hwa._time = 10000;
+
+    Packet packet = {};
+
+    packet.data.at(packet.size++) = 0xBF;    // header, timestamp 8190 (0x1FFE)
+    packet.data.at(packet.size++) = 0xFE;    // timestamp
+    packet.data.at(packet.size++) = 0x90;    // note on
+    packet.data.at(packet.size++) = 0x00;    // note index
+    packet.data.at(packet.size++) = 0x7F;    // velocity
+    packet.data.at(packet.size++) = 0x83;    // timestamp low overflowed, 8195
+    packet.data.at(packet.size++) = 0x90;    // note on
+    packet.data.at(packet.size++) = 0x01;    // note index
+    packet.data.at(packet.size++) = 0x7F;    // velocity
+
+    _hwa._readPackets.push_back(packet);
+
+    // newest message in the packet is aligned to the moment of reception
+    ASSERT_TRUE(_ble.read());
+    EXPECT_EQ(9995, _ble.timestamp());
+    ASSERT_TRUE(_ble.read());
+    EXPECT_EQ(10000, _ble.timestamp());
+
+    // 13-bit timestamp rolled over, message sent 20 ms later arrives with 10 ms more latency
+    packet      = {};
+    _hwa._time  = 10030;
+    packet.size = 0;
+
+    packet.data.at(packet.size++) = 0x80;    // header, timestamp 8215 (23 after rollover)
+    packet.data.at(packet.size++) = 0x97;    // timestamp
+    packet.data.at(packet.size++) = 0xF8;    // clock
+
+    _hwa._readPackets.push_back(packet);
+
+    ASSERT_TRUE(_ble.read());
+    EXPECT_EQ(messageType_t::SYS_REAL_TIME_CLOCK, _ble.type());
+    EXPECT_EQ(10020, _ble.timestamp());
+}
+
+TEST_F(BleMidiTest, RealTimeWithinSysEx)
+{
+    const std::vector<uint8_t> SYS_EX = { 0xF0, 0x01, 0x02, 0xF7 };
+
+    _ble.setSysExChunkSize(2);
+    ASSERT_TRUE(_ble.injectRealTime(messageType_t::SYS_REAL_TIME_CLOCK));
+    ASSERT_TRUE(_ble.sendSysEx(SYS_EX.size(), SYS_EX.data(), true));
+    ASSERT_EQ(1, _hwa._writePackets.size());
+
+    // every Real Time byte gets its own timestamp
+    const std::vector<uint8_t> EXPECTED = { 0x81, 0x80, 0xF0, 0x01, 0x80, 0xF8, 0x02, 0x80, 0xF7 };
+    const auto&                PACKET   = _hwa._writePackets.at(0);
+
+    EXPECT_EQ(EXPECTED, std::vector<uint8_t>(PACKET.data.begin(), PACKET.data.begin() + PACKET.size));
+
+    _hwa._readPackets = _hwa._writePackets;
+
+    ASSERT_TRUE(_ble.read());
+    EXPECT_EQ(messageType_t::SYS_REAL_TIME_CLOCK, _ble.type());
+    ASSERT_TRUE(_ble.read());
+    EXPECT_EQ(messageType_t::SYS_EX, _ble.type());
+    EXPECT_EQ(SYS_EX.size(), _ble.length());
+}
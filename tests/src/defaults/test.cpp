@@ -0,0 +1,153 @@
+#include "tests/common.h"
+#include "lib/midi/transport/serial/serial.h"
+#include "lib/midi/transport/usb/usb.h"
+
+using namespace lib::midi;
+
+namespace
+{
+    class DefaultsTest : public ::testing::Test
+    {
+        protected:
+        void SetUp()
+        {
+            ASSERT_TRUE(_serial.init());
+            ASSERT_TRUE(_usb.init());
+        }
+
+        void TearDown()
+        {}
+
+        class SerialHwa : public serial::Hwa
+        {
+            public:
+            bool init() override
+            {
+                return true;
+            }
+
+            bool deInit() override
+            {
+                return true;
+            }
+
+            bool write(serial::Packet& packet) override
+            {
+                _data.push_back(packet.data);
+                return true;
+            }
+
+            bool read(serial::Packet& packet) override
+            {
+                if (_readIndex == _data.size())
+                {
+                    return false;
+                }
+
+                packet.data = _data.at(_readIndex++);
+                return true;
+            }
+
+            std::vector<uint8_t> _data      = {};
+            size_t               _readIndex = 0;
+        };
+
+        class UsbHwa : public usb::Hwa
+        {
+            public:
+            bool init() override
+            {
+                return true;
+            }
+
+            bool deInit() override
+            {
+                return true;
+            }
+
+            bool write(usb::Packet& packet) override
+            {
+                _packets.push_back(packet.data);
+                return true;
+            }
+
+            bool read(usb::Packet& packet) override
+            {
+                if (_readIndex == _packets.size())
+                {
+                    return false;
+                }
+
+                packet.data = _packets.at(_readIndex++);
+                return true;
+            }
+
+            std::vector<std::array<uint8_t, 4>> _packets   = {};
+            size_t                              _readIndex = 0;
+        };
+
+        SerialHwa      _serialHwa;
+        serial::Serial _serial = serial::Serial(_serialHwa);
+        UsbHwa         _usbHwa;
+        usb::Usb       _usb = usb::Usb(_usbHwa);
+    };
+}    // namespace
+
+TEST_F(DefaultsTest, Configuration)
+{
+    EXPECT_EQ(0, MIDI_STATS);
+    EXPECT_EQ(0, MIDI_MESSAGE_QUEUE_SIZE);
+    EXPECT_EQ(0, MIDI_OUTPUT_QUEUE_SIZE);
+    EXPECT_EQ(1, MIDI_USB_TX_PACKETS);
+    EXPECT_LE(sizeof(Message), 8);
+}
+
+TEST_F(DefaultsTest, SerialLoopback)
+{
+    const std::vector<uint8_t> SYS_EX = { 0xF0, 0x01, 0x02, 0x03, 0xF7 };
+
+    ASSERT_TRUE(_serial.sendNoteOn(0x3C, 0x7F, 1));
+    ASSERT_TRUE(_serial.sendSysEx(SYS_EX.size(), SYS_EX.data(), true));
+    ASSERT_TRUE(_serial.sendRealTime(messageType_t::SYS_REAL_TIME_CLOCK));
+
+    ASSERT_TRUE(_serial.read());
+    EXPECT_EQ(messageType_t::NOTE_ON, _serial.type());
+    EXPECT_EQ(0x3C, _serial.data1());
+
+    ASSERT_TRUE(_serial.read());
+    EXPECT_EQ(messageType_t::SYS_EX, _serial.type());
+    EXPECT_EQ(SYS_EX.size(), _serial.length());
+
+    ASSERT_TRUE(_serial.read());
+    EXPECT_EQ(messageType_t::SYS_REAL_TIME_CLOCK, _serial.type());
+    EXPECT_FALSE(_serial.read());
+}
+
+TEST_F(DefaultsTest, UsbLoopback)
+{
+    // every packet is written at once
+    ASSERT_TRUE(_usb.sendControlChange(0x07, 0x64, 2));
+    ASSERT_EQ(1, _usbHwa._packets.size());
+    EXPECT_EQ((std::array<uint8_t, 4>{ 0x0B, 0xB1, 0x07, 0x64 }), _usbHwa._packets.at(0));
+
+    ASSERT_TRUE(_usb.read());
+    EXPECT_EQ(messageType_t::CONTROL_CHANGE, _usb.type());
+    EXPECT_EQ(2, _usb.channel());
+    EXPECT_FALSE(_usb.read());
+}
+
+TEST_F(DefaultsTest, QueuesDisabled)
+{
+    Message clock;
+    clock.type = messageType_t::SYS_REAL_TIME_CLOCK;
+
+    ASSERT_TRUE(_serial.sendRealTime(messageType_t::SYS_REAL_TIME_CLOCK));
+
+    // nothing is decoded into the message queue or scheduled when the queues are disabled
+    EXPECT_EQ(0, _serial.poll(1));
+    EXPECT_FALSE(_serial.schedule(clock, 0));
+    EXPECT_EQ(0, _serial.scheduled());
+
+    ASSERT_TRUE(_serial.read());
+    EXPECT_EQ(messageType_t::SYS_REAL_TIME_CLOCK, _serial.type());
+}
@@ -0,0 +1,754 @@
+#include "tests/common.h"
+#include "lib/midi/midi.h"
+#include "lib/midi/dejitter.h"
+#include "lib/midi/queue.h"
+#include "lib/midi/router.h"
+#include <thread>
+
+using namespace lib::midi;
+
+namespace
+{
+    class MidiParseTest : public ::testing::Test
+    {
+        protected:
+        void SetUp()
+        {
+            ASSERT_TRUE(_midi.init());
+            _midi.useRecursiveParsing(true);
+        }
+
+        void TearDown()
+        {}
+
+        class TestTransport : public Transport
+        {
+            public:
+            TestTransport() = default;
+
+            bool init() override
+            {
+                return true;
+            }
+
+            bool deInit() override
+            {
+                return true;
+            }
+
+            bool beginTransmission(messageType_t type) override
+            {
+                return true;
+            }
+
+            bool write(uint8_t data) override
+            {
+                _writeData.push_back(data);
+                return true;
+            }
+
+            bool endTransmission() override
+            {
+                return true;
+            }
+
+            bool read(uint8_t& data) override
+            {
+                if (_readData.size())
+                {
+                    data = _readData.at(0);
+                    _readData.erase(_readData.begin());
+
+                    return true;
+                }
+
+                return false;
+            }
+
+            std::vector<uint8_t> _writeData = {};
+            std::vector<uint8_t> _readData  = {};
+        };
+
+        class TestSink : public Sink
+        {
+            public:
+            void process(const Message& message) override
+            {
+                _messages.push_back(message);
+            }
+
+            std::vector<Message> _messages = {};
+        };
+
+        TestTransport _transport;
+        Base          _midi = Base(_transport);
+    };
+
+    const std::vector<uint8_t> STREAM = {
+        0x90,
+        0x3C,
+        0x7F,    // note on
+        0x3D,
+        0xF8,    // clock interleaved in running status
+        0x70,
+        0xB2,
+        0x07,
+        0x64,    // control change, channel 3
+        0xF0,
+        0x01,
+        0x02,
+        0xFE,    // active sensing interleaved in sysex
+        0x03,
+        0xF7,
+        0xC0,
+        0x05,    // program change
+        0x06,    // program change with running status
+    };
+}    // namespace
+
+TEST_F(MidiParseTest, SpanMatchesTransportParsing)
+{
+    _transport._readData = STREAM;
+
+    std::vector<Message> expected;
+
+    while (_midi.read())
+    {
+        expected.push_back(_midi.message());
+    }
+
+    ASSERT_EQ(8, expected.size());
+
+    TestSink sink;
+    Base     spanMidi = Base(_transport);
+
+    ASSERT_EQ(expected.size(), spanMidi.parse(STREAM.data(), STREAM.size(), sink));
+    ASSERT_EQ(expected.size(), sink._messages.size());
+
+    for (size_t i = 0; i < expected.size(); i++)
+    {
+        EXPECT_EQ(expected.at(i).type, sink._messages.at(i).type);
+        EXPECT_EQ(expected.at(i).channel, sink._messages.at(i).channel);
+        EXPECT_EQ(expected.at(i).data1, sink._messages.at(i).data1);
+        EXPECT_EQ(expected.at(i).data2, sink._messages.at(i).data2);
+    }
+
+    EXPECT_EQ(messageType_t::SYS_EX, sink._messages.at(5).type);
+    EXPECT_EQ(5, sink._messages.at(5).length);
+    EXPECT_EQ(messageType_t::PROGRAM_CHANGE, sink._messages.at(7).type);
+    EXPECT_EQ(6, sink._messages.at(7).data1);
+
+    const std::vector<uint8_t> SYS_EX = { 0xF0, 0x01, 0x02, 0x03, 0xF7 };
+    EXPECT_EQ(SYS_EX, std::vector<uint8_t>(spanMidi.sysExArray(), spanMidi.sysExArray() + SYS_EX.size()));
+    EXPECT_LE(sizeof(Message), 8);
+}
+
+TEST_F(MidiParseTest, SpanSplitBetweenBuffers)
+{
+    TestSink sink;
+
+    // message split between two buffers is completed by the second one
+    for (size_t i = 0; i < STREAM.size(); i++)
+    {
+        _midi.parse(&STREAM.at(i), 1, sink);
+    }
+
+    ASSERT_EQ(8, sink._messages.size());
+    EXPECT_EQ(messageType_t::NOTE_ON, sink._messages.at(0).type);
+    EXPECT_EQ(messageType_t::SYS_REAL_TIME_CLOCK, sink._messages.at(1).type);
+    EXPECT_EQ(messageType_t::NOTE_ON, sink._messages.at(2).type);
+    EXPECT_EQ(0x3D, sink._messages.at(2).data1);
+    EXPECT_EQ(0x70, sink._messages.at(2).data2);
+    EXPECT_EQ(3, sink._messages.at(3).channel);
+}
+
+TEST_F(MidiParseTest, StatusByteInterruptsPendingMessage)
+{
+    TestSink sink;
+
+    const std::vector<uint8_t> DATA = {
+        0x90,
+        0x3C,    // incomplete note on
+        0xB0,
+        0x01,
+        0x02,    // control change
+        0xF4,    // undefined status byte, running status is cleared
+        0x03,
+        0x04,
+    };
+
+    ASSERT_EQ(1, _midi.parse(DATA.data(), DATA.size(), sink));
+    EXPECT_EQ(messageType_t::CONTROL_CHANGE, sink._messages.at(0).type);
+    EXPECT_EQ(1, sink._messages.at(0).data1);
+    EXPECT_EQ(2, sink._messages.at(0).data2);
+    EXPECT_EQ(3, sink._messages.at(0).length);
+}
+
+TEST_F(MidiParseTest, StreamSysEx)
+{
+    class TestStream : public SysExStream
+    {
+        public:
+        void sysExChunk(sysExChunk_t type, const uint8_t* data, size_t size) override
+        {
+            _types.push_back(type);
+            _data.insert(_data.end(), data, data + size);
+        }
+
+        std::vector<sysExChunk_t> _types = {};
+        std::vector<uint8_t>      _data  = {};
+    };
+
+    TestSink   sink;
+    TestStream stream;
+
+    _midi.setSysExStream(&stream);
+
+    std::vector<uint8_t> sysEx = { 0xF0 };
+
+    for (size_t i = 0; i < (MIDI_SYSEX_ARRAY_SIZE * 3); i++)
+    {
+        sysEx.push_back(i & 0x7F);
+    }
+
+    sysEx.push_back(0xF7);
+
+    ASSERT_EQ(0, _midi.parse(sysEx.data(), sysEx.size(), sink));
+
+    const std::vector<sysExChunk_t> EXPECTED_TYPES = {
+        sysExChunk_t::START,
+        sysExChunk_t::CONTINUE,
+        sysExChunk_t::CONTINUE,
+        sysExChunk_t::END,
+    };
+
+    EXPECT_EQ(EXPECTED_TYPES, stream._types);
+    EXPECT_EQ(sysEx, stream._data);
+
+    // short message is delivered at once
+    const std::vector<uint8_t> SHORT_SYS_EX = { 0xF0, 0x01, 0xF8, 0x02, 0xF7 };
+
+    stream._types.clear();
+    ASSERT_EQ(1, _midi.parse(SHORT_SYS_EX.data(), SHORT_SYS_EX.size(), sink));
+    EXPECT_EQ(messageType_t::SYS_REAL_TIME_CLOCK, sink._messages.at(0).type);
+    ASSERT_EQ(1, stream._types.size());
+    EXPECT_EQ(sysExChunk_t::COMPLETE, stream._types.at(0));
+
+    // interrupted message
+    stream._types.clear();
+    ASSERT_EQ(0, _midi.parse(sysEx.data(), MIDI_SYSEX_ARRAY_SIZE + 1, sink));
+
+    const std::vector<uint8_t> NOTE_ON = { 0x90, 0x00, 0x7F };
+
+    ASSERT_EQ(1, _midi.parse(NOTE_ON.data(), NOTE_ON.size(), sink));
+    EXPECT_EQ((std::vector<sysExChunk_t>{ sysExChunk_t::START, sysExChunk_t::ABORT }), stream._types);
+}
+
+TEST_F(MidiParseTest, Stats)
+{
+    TestSink sink;
+
+    const std::vector<uint8_t> DATA = {
+        0x01,    // data byte without status
+        0x90,
+        0x3C,    // incomplete note on
+        0xB0,
+        0x01,
+        0x02,
+        0x03,
+        0x04,    // control change with running status
+        0xF7,    // stray EOX
+        0xF4,    // undefined status byte
+        0xF8,
+    };
+
+    ASSERT_EQ(3, _midi.parse(DATA.data(), DATA.size(), sink));
+
+    auto stats = _midi.stats();
+
+    EXPECT_EQ(DATA.size(), stats.bytesIn);
+    EXPECT_EQ(2, stats.received[Stats::index(messageType_t::CONTROL_CHANGE)]);
+    EXPECT_EQ(1, stats.received[Stats::index(messageType_t::SYS_REAL_TIME_CLOCK)]);
+    EXPECT_EQ(0, stats.received[Stats::index(messageType_t::NOTE_ON)]);
+    EXPECT_EQ(1, stats.runningStatusIn);
+    EXPECT_EQ(1, stats.parseErrors[static_cast<size_t>(parseError_t::MISSING_STATUS)]);
+    EXPECT_EQ(1, stats.parseErrors[static_cast<size_t>(parseError_t::INTERRUPTED)]);
+    EXPECT_EQ(1, stats.parseErrors[static_cast<size_t>(parseError_t::STRAY_EOX)]);
+    EXPECT_EQ(1, stats.parseErrors[static_cast<size_t>(parseError_t::UNDEFINED_STATUS)]);
+
+    _midi.setRunningStatusState(true);
+
+    ASSERT_TRUE(_midi.sendNoteOn(60, 127, 1));
+    ASSERT_TRUE(_midi.sendNoteOn(61, 127, 1));
+    ASSERT_TRUE(_midi.sendSongPosition(10));
+    ASSERT_FALSE(_midi.sendNoteOn(60, 127, 17));
+
+    stats = _midi.stats();
+
+    EXPECT_EQ(_transport._writeData.size(), stats.bytesOut);
+    EXPECT_EQ(2, stats.sent[Stats::index(messageType_t::NOTE_ON)]);
+    EXPECT_EQ(1, stats.sent[Stats::index(messageType_t::SYS_COMMON_SONG_POSITION)]);
+    EXPECT_EQ(1, stats.runningStatusOut);
+    EXPECT_EQ(0, stats.sendFailures);
+
+    _midi.clearStats();
+    EXPECT_EQ(0, _midi.stats().bytesIn);
+}
+
+TEST_F(MidiParseTest, Dejitter)
+{
+    Dejitter dejitter(20);
+    Message  message;
+
+    // messages received in a single batch are released with their original spacing
+    for (uint32_t timestamp : { 100, 105, 112 })
+    {
+        message.data1 = timestamp;
+        ASSERT_TRUE(dejitter.push(message, timestamp));
+    }
+
+    EXPECT_FALSE(dejitter.pop(119, message));
+    ASSERT_TRUE(dejitter.pop(120, message));
+    EXPECT_EQ(100, message.data1);
+    EXPECT_FALSE(dejitter.pop(124, message));
+    ASSERT_TRUE(dejitter.pop(125, message));
+    EXPECT_EQ(105, message.data1);
+
+    // late message is released at once
+    ASSERT_TRUE(dejitter.pop(200, message));
+    EXPECT_EQ(112, message.data1);
+    EXPECT_FALSE(dejitter.pop(200, message));
+
+    for (size_t i = 0; i < MIDI_DEJITTER_BUFFER_SIZE; i++)
+    {
+        ASSERT_TRUE(dejitter.push(message, 200));
+    }
+
+    EXPECT_FALSE(dejitter.push(message, 200));
+    EXPECT_EQ(MIDI_DEJITTER_BUFFER_SIZE, dejitter.size());
+
+    dejitter.clear();
+    EXPECT_EQ(0, dejitter.size());
+}
+
+TEST_F(MidiParseTest, RunningStatusEncoder)
+{
+    _midi.setRunningStatusState(true);
+    _midi.setNoteOffMode(noteOffType_t::KEEP_RUNNING_STATUS);
+
+    // clock is transparent, note off keeps running status
+    ASSERT_TRUE(_midi.sendNoteOn(0x3C, 0x7F, 1));
+    ASSERT_TRUE(_midi.sendRealTime(messageType_t::SYS_REAL_TIME_CLOCK));
+    ASSERT_TRUE(_midi.sendNoteOff(0x3C, 0x40, 1));
+
+    // note off can't keep running status on another channel
+    ASSERT_TRUE(_midi.sendNoteOff(0x3C, 0x40, 2));
+
+    EXPECT_EQ((std::vector<uint8_t>{ 0x90, 0x3C, 0x7F, 0xF8, 0x3C, 0x00, 0x81, 0x3C, 0x40 }), _transport._writeData);
+
+    // status is sent again once the refresh limit is reached or when requested
+    _transport._writeData.clear();
+    _midi.setRunningStatusRefresh(4);
+
+    for (size_t i = 0; i < 3; i++)
+    {
+        ASSERT_TRUE(_midi.sendControlChange(7, i, 1));
+    }
+
+    _midi.refreshRunningStatus();
+    ASSERT_TRUE(_midi.sendControlChange(7, 3, 1));
+
+    // system common message cancels running status
+    ASSERT_TRUE(_midi.sendSongSelect(1));
+    ASSERT_TRUE(_midi.sendControlChange(7, 4, 1));
+
+    const std::vector<uint8_t> EXPECTED = {
+        0xB0,
+        0x07,
+        0x00,
+        0x07,
+        0x01,
+        0xB0,
+        0x07,
+        0x02,
+        0xB0,
+        0x07,
+        0x03,
+        0xF3,
+        0x01,
+        0xB0,
+        0x07,
+        0x04,
+    };
+
+    EXPECT_EQ(EXPECTED, _transport._writeData);
+
+    // received data doesn't affect outgoing running status, only reinitialization does
+    _transport._writeData.clear();
+    _transport._readData = { 0xF7, 0xF4 };
+
+    EXPECT_FALSE(_midi.read());
+    EXPECT_FALSE(_midi.read());
+    EXPECT_TRUE(_transport._readData.empty());
+    ASSERT_TRUE(_midi.sendControlChange(7, 5, 1));
+
+    ASSERT_TRUE(_midi.deInit());
+    ASSERT_TRUE(_midi.init());
+    ASSERT_TRUE(_midi.sendControlChange(7, 6, 1));
+
+    EXPECT_EQ((std::vector<uint8_t>{ 0x07, 0x05, 0xB0, 0x07, 0x06 }), _transport._writeData);
+}
+
+TEST_F(MidiParseTest, Schedule)
+{
+    const std::vector<uint8_t> SYS_EX = { 0xF0, 0x01, 0x02, 0x03, 0xF7 };
+
+    Message controlChange;
+    controlChange.type  = messageType_t::CONTROL_CHANGE;
+    controlChange.data1 = 0x07;
+    controlChange.data2 = 0x64;
+
+    Message noteOn;
+    noteOn.type  = messageType_t::NOTE_ON;
+    noteOn.data1 = 0x3C;
+    noteOn.data2 = 0x7F;
+
+    Message clock;
+    clock.type = messageType_t::SYS_REAL_TIME_CLOCK;
+
+    _midi.setSysExChunkSize(2);
+
+    ASSERT_TRUE(_midi.scheduleSysEx(SYS_EX.data(), SYS_EX.size(), 10));
+    ASSERT_TRUE(_midi.schedule(controlChange, 10));
+    ASSERT_TRUE(_midi.schedule(clock, 11));
+    ASSERT_TRUE(_midi.schedule(noteOn, 5));
+    ASSERT_TRUE(_midi.schedule(noteOn, 5));
+    ASSERT_FALSE(_midi.schedule(noteOn, 5));
+    EXPECT_EQ(5, _midi.scheduled());
+
+    EXPECT_EQ(0, _midi.tick(4));
+    EXPECT_EQ(2, _midi.tick(5));
+    EXPECT_EQ((std::vector<uint8_t>{ 0x90, 0x3C, 0x7F, 0x90, 0x3C, 0x7F }), _transport._writeData);
+
+    // control change scheduled for the same time waits for the entire SysEx message
+    _transport._writeData.clear();
+    EXPECT_EQ(1, _midi.tick(10));
+    EXPECT_EQ(1, _midi.tick(11));
+    EXPECT_EQ(1, _midi.tick(12));
+    EXPECT_EQ(0, _midi.scheduled());
+
+    // clock is sent between parts of SysEx message
+    const std::vector<uint8_t> EXPECTED = { 0xF0, 0x01, 0xF8, 0x02, 0x03, 0xF7, 0xB0, 0x07, 0x64 };
+
+    EXPECT_EQ(EXPECTED, _transport._writeData);
+}
+
+TEST_F(MidiParseTest, ScheduledSysExChunkSizeCleared)
+{
+    const std::vector<uint8_t> SYS_EX = { 0xF0, 0x01, 0x02, 0x03, 0x04, 0x05, 0xF7 };
+
+    Message noteOn;
+    noteOn.type    = messageType_t::NOTE_ON;
+    noteOn.channel = 1;
+    noteOn.data1   = 0x3C;
+    noteOn.data2   = 0x7F;
+
+    _midi.setSysExChunkSize(2);
+
+    ASSERT_TRUE(_midi.scheduleSysEx(SYS_EX.data(), SYS_EX.size(), 0));
+    ASSERT_TRUE(_midi.schedule(noteOn, 0));
+    EXPECT_EQ(1, _midi.tick(0));
+
+    // rest of the message is sent at once instead of stalling the queue
+    _midi.setSysExChunkSize(0);
+    EXPECT_EQ(1, _midi.tick(1));
+    EXPECT_EQ(0, _midi.scheduled());
+
+    std::vector<uint8_t> expected = SYS_EX;
+    expected.insert(expected.end(), { 0x90, 0x3C, 0x7F });
+
+    EXPECT_EQ(expected, _transport._writeData);
+}
+
+TEST_F(MidiParseTest, SendDuringScheduledSysEx)
+{
+    const std::vector<uint8_t> SYS_EX = { 0xF0, 0x01, 0x02, 0x03, 0xF7 };
+
+    _midi.setSysExChunkSize(2);
+
+    ASSERT_TRUE(_midi.scheduleSysEx(SYS_EX.data(), SYS_EX.size(), 0));
+    EXPECT_EQ(1, _midi.tick(0));
+
+    // anything but Real Time would end the SysEx message at the receiver
+    EXPECT_FALSE(_midi.sendNoteOn(0x3C, 0x7F, 1));
+    EXPECT_FALSE(_midi.sendSongSelect(1));
+    EXPECT_FALSE(_midi.sendSysEx(SYS_EX.size(), SYS_EX.data(), true));
+    EXPECT_TRUE(_midi.sendRealTime(messageType_t::SYS_REAL_TIME_CLOCK));
+
+    EXPECT_EQ(0, _midi.tick(1));
+    EXPECT_EQ(0, _midi.tick(2));
+    EXPECT_TRUE(_midi.sendNoteOn(0x3C, 0x7F, 1));
+
+    const std::vector<uint8_t> EXPECTED = { 0xF0, 0x01, 0xF8, 0x02, 0x03, 0xF7, 0x90, 0x3C, 0x7F };
+
+    EXPECT_EQ(EXPECTED, _transport._writeData);
+}
+
+TEST_F(MidiParseTest, RealTimeWithinSysEx)
+{
+    const std::vector<uint8_t> SYS_EX = { 0xF0, 0x01, 0x02, 0x03, 0xF7 };
+
+    ASSERT_FALSE(_midi.injectRealTime(messageType_t::NOTE_ON));
+
+    // injected before the transmission, written after the first slice
+    _midi.setSysExChunkSize(2);
+    ASSERT_TRUE(_midi.injectRealTime(messageType_t::SYS_REAL_TIME_START));
+    ASSERT_TRUE(_midi.injectRealTime(messageType_t::SYS_REAL_TIME_CLOCK));
+    ASSERT_TRUE(_midi.sendSysEx(SYS_EX.size(), SYS_EX.data(), true));
+
+    EXPECT_EQ((std::vector<uint8_t>{ 0xF0, 0x01, 0xFA, 0xF8, 0x02, 0x03, 0xF7 }), _transport._writeData);
+
+    _transport._writeData.clear();
+    ASSERT_TRUE(_midi.injectRealTime(messageType_t::SYS_REAL_TIME_STOP));
+    ASSERT_TRUE(_midi.sendPendingRealTime());
+    EXPECT_EQ((std::vector<uint8_t>{ 0xFC }), _transport._writeData);
+}
+
+TEST_F(MidiParseTest, ThruFilter)
+{
+    TestTransport all;
+    TestTransport notes;
+    TestTransport clock;
+
+    ThruFilter notesFilter;
+    notesFilter.types    = ThruFilter::typeBit(messageType_t::NOTE_ON) | ThruFilter::typeBit(messageType_t::NOTE_OFF);
+    notesFilter.channels = ThruFilter::channelBit(1);
+    notesFilter.remap    = 10;
+
+    ThruFilter clockFilter;
+    clockFilter.types = ThruFilter::typeBit(messageType_t::SYS_REAL_TIME_CLOCK);
+
+    _midi.registerThruInterface(all);
+    _midi.registerThruInterface(notes, notesFilter);
+    _midi.registerThruInterface(clock);
+    ASSERT_TRUE(_midi.setThruFilter(clock, clockFilter));
+    ASSERT_FALSE(_midi.setThruFilter(_transport, clockFilter));
+
+    _transport._readData = STREAM;
+
+    while (_midi.read())
+    {
+    }
+
+    // note on with running status is forwarded with status byte
+    EXPECT_EQ((std::vector<uint8_t>{ 0x99, 0x3C, 0x7F, 0x99, 0x3D, 0x70 }), notes._writeData);
+    EXPECT_EQ((std::vector<uint8_t>{ 0xF8 }), clock._writeData);
+    EXPECT_EQ(20, all._writeData.size());
+}
+
+TEST_F(MidiParseTest, RawThru)
+{
+    TestTransport raw;
+    TestTransport late;
+    TestTransport encoded;
+
+    ThruFilter rawFilter;
+    rawFilter.raw = true;
+
+    _midi.registerThruInterface(raw, rawFilter);
+    _midi.registerThruInterface(encoded);
+
+    _transport._readData = STREAM;
+
+    ASSERT_TRUE(_midi.read());
+
+    // interface registered in the middle of running status gets the status byte first
+    _midi.registerThruInterface(late, rawFilter);
+
+    while (_midi.read())
+    {
+    }
+
+    // real time message interleaved in running status is forwarded as soon as it's received
+    const std::vector<uint8_t> EXPECTED = {
+        0x90,
+        0x3C,
+        0x7F,
+        0xF8,
+        0x3D,
+        0x70,
+        0xB2,
+        0x07,
+        0x64,
+        0xFE,
+        0xF0,
+        0x01,
+        0x02,
+        0x03,
+        0xF7,
+        0xC0,
+        0x05,
+        0x06,
+    };
+
+    EXPECT_EQ(EXPECTED, raw._writeData);
+    EXPECT_EQ((std::vector<uint8_t>{ 0xF8, 0x90, 0x3D, 0x70 }), std::vector<uint8_t>(late._writeData.begin(), late._writeData.begin() + 4));
+    EXPECT_EQ(EXPECTED.size() - 2, late._writeData.size());
+    EXPECT_EQ(EXPECTED.size() + 2, encoded._writeData.size());
+}
+
+TEST_F(MidiParseTest, RawThruSharedOutput)
+{
+    TestTransport out;
+    Base          output(out);
+
+    ThruFilter rawFilter;
+    rawFilter.raw = true;
+
+    ASSERT_TRUE(output.init());
+    output.setRunningStatusState(true);
+    _midi.registerThruInterface(out, rawFilter);
+
+    // second note is received with running status
+    _transport._readData = { 0x90, 0x3C, 0x7F, 0x3D, 0x70 };
+
+    ASSERT_TRUE(_midi.read());
+
+    // application sends its own message to the same interface in the meantime
+    ASSERT_TRUE(output.sendControlChange(0x07, 0x64, 3));
+
+    // status has changed on the wire, so it's written again when forwarding
+    ASSERT_TRUE(_midi.read());
+
+    // and the output instance continues with the status written by thru
+    ASSERT_TRUE(output.sendNoteOn(0x3E, 0x7F, 1));
+
+    const std::vector<uint8_t> EXPECTED = { 0x90, 0x3C, 0x7F, 0xB2, 0x07, 0x64, 0x90, 0x3D, 0x70, 0x3E, 0x7F };
+
+    EXPECT_EQ(EXPECTED, out._writeData);
+}
+
+TEST_F(MidiParseTest, EventQueue)
+{
+    EventQueue<4> queue;
+    Event         event;
+
+    for (size_t i = 0; i < queue.capacity(); i++)
+    {
+        ASSERT_TRUE(queue.push(event));
+    }
+
+    ASSERT_FALSE(queue.push(event));
+    ASSERT_TRUE(queue.pop(event));
+    ASSERT_TRUE(queue.push(event));
+
+    while (queue.pop(event))
+    {
+    }
+
+    // messages decoded on one side are sent with their original contents on the other
+    QueueReader<Base, 4> reader(_midi, queue);
+    QueueWriter<Base, 4> writer(_midi, queue);
+
+    _transport._readData = { 0x92, 0x3C, 0x7F, 0xF8, 0xF0, 0x01, 0xF7, 0xF2, 0x10, 0x20 };
+
+    ASSERT_EQ(3, reader.update());
+    EXPECT_EQ(3, writer.update());
+    EXPECT_EQ((std::vector<uint8_t>{ 0x92, 0x3C, 0x7F, 0xF8, 0xF2, 0x10, 0x20 }), _transport._writeData);
+
+    // handoff between two threads keeps the order
+    constexpr uint32_t EVENTS   = 10000;
+    uint32_t           expected = 0;
+    bool               ordered  = true;
+
+    std::thread producer([&queue]() {
+        for (uint32_t i = 0; i < EVENTS;)
+        {
+            Event event;
+            event.timestamp = i;
+
+            if (queue.push(event))
+            {
+                i++;
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    while (expected < EVENTS)
+    {
+        if (!queue.pop(event))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        ordered &= (event.timestamp == expected++);
+    }
+
+    producer.join();
+    EXPECT_TRUE(ordered);
+}
+
+TEST_F(MidiParseTest, Router)
+{
+    TestTransport transport1;
+    TestTransport transport2;
+    Base          midi1(transport1);
+    Base          midi2(transport2);
+
+    Router::MidiPort<Base> port0(_midi);
+    Router::MidiPort<Base> port1(midi1);
+    Router::MidiPort<Base> port2(midi2);
+    Router                 router;
+
+    ASSERT_EQ(0, router.addPort(port0, 0));
+    ASSERT_EQ(1, router.addPort(port1, 0));
+    ASSERT_EQ(2, router.addPort(port2, 1));
+    ASSERT_EQ(Router::INVALID_PORT, router.addPort(port2, MIDI_ROUTER_MAX_WORKERS));
+    ASSERT_TRUE(router.connect(0, 1));
+    ASSERT_TRUE(router.connect(0, 2));
+    ASSERT_FALSE(router.connect(0, 3));
+
+    _transport._readData = { 0x92, 0x3C, 0x7F, 0xF8 };
+
+    // port owned by the same worker gets messages at once, the other one once its worker is updated
+    EXPECT_EQ(2, router.update(0));
+    EXPECT_EQ((std::vector<uint8_t>{ 0x92, 0x3C, 0x7F, 0xF8 }), transport1._writeData);
+    EXPECT_TRUE(transport2._writeData.empty());
+
+    EXPECT_EQ(2, router.update(1));
+    EXPECT_EQ(transport1._writeData, transport2._writeData);
+
+    EXPECT_EQ(2, router.load(0).received);
+    EXPECT_EQ(2, router.load(2).sent);
+
+    // after rebalancing, all ports are handled by a single worker
+    ASSERT_TRUE(router.assign(2, 0));
+    ASSERT_TRUE(router.disconnect(0, 1));
+
+    transport2._writeData.clear();
+    _transport._readData = { 0xFA };
+
+    EXPECT_EQ(1, router.update(0));
+    EXPECT_EQ((std::vector<uint8_t>{ 0xFA }), transport2._writeData);
+    EXPECT_EQ(4, transport1._writeData.size());
+
+    // busy port doesn't hold back the others: only a batch is read from every port per update
+    ASSERT_TRUE(router.connect(1, 2));
+
+    transport2._writeData.clear();
+    _transport._readData = { 0xF8, 0xF8, 0xF8 };
+    transport1._readData = { 0xFA };
+
+    EXPECT_EQ(2, router.update(0, 1));
+    EXPECT_EQ((std::vector<uint8_t>{ 0xF8, 0xFA }), transport2._writeData);
+
+    EXPECT_EQ(1, router.update(0, 1));
+    EXPECT_EQ(1, router.update(0, 1));
+    EXPECT_EQ(0, router.update(0, 1));
+    EXPECT_EQ((std::vector<uint8_t>{ 0xF8, 0xFA, 0xF8, 0xF8 }), transport2._writeData);
+}
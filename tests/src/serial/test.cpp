@@ -0,0 +1,239 @@
+#include "tests/common.h"
+#include "lib/midi/transport/serial/serial.h"
+#include "lib/midi/transport/serial/buffered.h"
+
+using namespace lib::midi;
+using namespace serial;
+
+namespace
+{
+    class SerialMidiTest : public ::testing::Test
+    {
+        protected:
+        void SetUp()
+        {
+            ASSERT_TRUE(_serial.init());
+        }
+
+        void TearDown()
+        {}
+
+        class SerialHwa : public BufferedHwa
+        {
+            public:
+            SerialHwa() = default;
+
+            bool init() override
+            {
+                return true;
+            }
+
+            bool deInit() override
+            {
+                return true;
+            }
+
+            void startTransmission() override
+            {
+                _transmissions++;
+            }
+
+            size_t read(uint8_t* data, size_t size) override
+            {
+                _readCalls++;
+                return BufferedHwa::read(data, size);
+            }
+
+            // every wait delivers the next chunk of data, as if it was received in the meantime
+            bool wait(uint32_t& timeout) override
+            {
+                _waits++;
+                timeout -= std::min(timeout, WAIT_TIME);
+
+                if (_arrivals.empty())
+                {
+                    return false;
+                }
+
+                rxBuffer().write(_arrivals.front().data(), _arrivals.front().size());
+                _arrivals.erase(_arrivals.begin());
+
+                return true;
+            }
+
+            static constexpr uint32_t         WAIT_TIME      = 5;
+            size_t                            _transmissions = 0;
+            size_t                            _readCalls     = 0;
+            size_t                            _waits         = 0;
+            std::vector<std::vector<uint8_t>> _arrivals      = {};
+        };
+
+        SerialHwa _hwa;
+        Serial    _serial = Serial(_hwa);
+    };
+}    // namespace
+
+TEST_F(SerialMidiTest, Ring)
+{
+    Ring<8> ring;
+    uint8_t data = 0;
+
+    ASSERT_FALSE(ring.pop(data));
+
+    const uint8_t BLOCK[] = { 1, 2, 3, 4, 5, 6 };
+
+    ASSERT_EQ(6, ring.write(BLOCK, sizeof(BLOCK)));
+    ASSERT_TRUE(ring.pop(data));
+    EXPECT_EQ(1, data);
+
+    // only the remaining room is filled, wrapping around the end of the buffer
+    ASSERT_EQ(3, ring.write(BLOCK, sizeof(BLOCK)));
+    ASSERT_FALSE(ring.push(7));
+    EXPECT_EQ(8, ring.size());
+
+    size_t         size = 0;
+    const uint8_t* span = ring.readSpan(size);
+
+    ASSERT_EQ(7, size);
+    EXPECT_EQ(2, span[0]);
+    ring.consume(size);
+
+    span = ring.readSpan(size);
+    ASSERT_EQ(1, size);
+    EXPECT_EQ(3, span[0]);
+    ring.consume(size);
+    EXPECT_EQ(0, ring.size());
+
+    uint8_t* free = ring.writeSpan(size);
+
+    ASSERT_EQ(7, size);
+    free[0] = 8;
+    ring.commit(1);
+
+    uint8_t out[8] = {};
+
+    ASSERT_EQ(1, ring.read(out, sizeof(out)));
+    EXPECT_EQ(8, out[0]);
+}
+
+TEST_F(SerialMidiTest, ReadFromRing)
+{
+    const std::vector<uint8_t> DATA = {
+        0x90,
+        0x3C,
+        0x7F,    // note on
+        0x3D,
+        0x70,    // note on with running status
+        0xF8,    // clock
+    };
+
+    // receive interrupt
+    for (auto data : DATA)
+    {
+        ASSERT_TRUE(_hwa.rxBuffer().push(data));
+    }
+
+    ASSERT_TRUE(_serial.read());
+    EXPECT_EQ(messageType_t::NOTE_ON, _serial.type());
+    EXPECT_EQ(0x3C, _serial.data1());
+
+    ASSERT_TRUE(_serial.read());
+    EXPECT_EQ(0x3D, _serial.data1());
+
+    ASSERT_TRUE(_serial.read());
+    EXPECT_EQ(messageType_t::SYS_REAL_TIME_CLOCK, _serial.type());
+
+    // all the data has been retrieved in a single block
+    EXPECT_EQ(1, _hwa._readCalls);
+    EXPECT_FALSE(_serial.read());
+}
+
+TEST_F(SerialMidiTest, WriteToRing)
+{
+    ASSERT_TRUE(_serial.sendNoteOn(0x3C, 0x7F, 1));
+
+    // entire message is queued at once
+    EXPECT_EQ(1, _hwa._transmissions);
+
+    const std::vector<uint8_t> SYS_EX = { 0xF0, 0x01, 0x02, 0x03, 0xF7 };
+
+    ASSERT_TRUE(_serial.sendSysEx(SYS_EX.size(), SYS_EX.data(), true));
+
+    std::vector<uint8_t> expected = { 0x90, 0x3C, 0x7F };
+    expected.insert(expected.end(), SYS_EX.begin(), SYS_EX.end());
+
+    std::vector<uint8_t> written(_hwa.txBuffer().size());
+    ASSERT_EQ(written.size(), _hwa.txBuffer().read(written.data(), written.size()));
+    EXPECT_EQ(expected, written);
+}
+
+TEST_F(SerialMidiTest, WriteToFullRing)
+{
+    const std::vector<uint8_t> FILL(_hwa.txBuffer().capacity(), 0xF8);
+    ASSERT_EQ(FILL.size(), _hwa.txBuffer().write(FILL.data(), FILL.size()));
+
+    // nothing is drained, so the write fails instead of blocking forever
+    EXPECT_FALSE(_serial.sendNoteOn(0x3C, 0x7F, 1));
+
+    // transmission is started even though no byte could be queued
+    EXPECT_EQ(1, _hwa._transmissions);
+    EXPECT_EQ(FILL.size(), _hwa.txBuffer().size());
+
+    // once there is room again, writing succeeds
+    std::vector<uint8_t> drained(FILL.size());
+    ASSERT_EQ(FILL.size(), _hwa.txBuffer().read(drained.data(), drained.size()));
+    ASSERT_TRUE(_serial.sendNoteOn(0x3C, 0x7F, 1));
+    EXPECT_EQ(2, _hwa._transmissions);
+    EXPECT_EQ(3, _hwa.txBuffer().size());
+}
+
+TEST_F(SerialMidiTest, BaseCompatible)
+{
+    SerialBase serial(_hwa);
+    Base&      base = serial;
+
+    ASSERT_TRUE(base.init());
+    ASSERT_TRUE(base.sendNoteOn(0x3C, 0x7F, 1));
+
+    std::vector<uint8_t> written(_hwa.txBuffer().size());
+    ASSERT_EQ(written.size(), _hwa.txBuffer().read(written.data(), written.size()));
+    EXPECT_EQ(std::vector<uint8_t>({ 0x90, 0x3C, 0x7F }), written);
+
+    const std::vector<uint8_t> STREAM = { 0x80, 0x3C, 0x00 };
+    ASSERT_EQ(STREAM.size(), _hwa.rxBuffer().write(STREAM.data(), STREAM.size()));
+
+    ASSERT_TRUE(base.read());
+    EXPECT_EQ(messageType_t::NOTE_OFF, base.type());
+    EXPECT_EQ(0x3C, base.data1());
+}
+
+TEST_F(SerialMidiTest, WaitForData)
+{
+    _hwa._arrivals = { { 0x90, 0x3C }, { 0x7F, 0xF8 } };
+
+    // message split between two arrivals
+    ASSERT_TRUE(_serial.read(10));
+    EXPECT_EQ(messageType_t::NOTE_ON, _serial.type());
+    EXPECT_EQ(2, _hwa._waits);
+
+    // remaining byte is read without waiting
+    ASSERT_TRUE(_serial.read(10));
+    EXPECT_EQ(messageType_t::SYS_REAL_TIME_CLOCK, _serial.type());
+    EXPECT_EQ(2, _hwa._waits);
+
+    EXPECT_FALSE(_serial.read(10));
+    EXPECT_EQ(3, _hwa._waits);
+}
+
+TEST_F(SerialMidiTest, WaitDeadline)
+{
+    // SysEx trickling in byte by byte mustn't keep the read blocked past the timeout
+    _hwa._arrivals = { { 0xF0 }, { 0x01 }, { 0x02 }, { 0x03 }, { 0x04 }, { 0xF7 } };
+
+    EXPECT_FALSE(_serial.read(10));
+    EXPECT_EQ(2, _hwa._waits);
+
+    ASSERT_TRUE(_serial.read(100));
+    EXPECT_EQ(messageType_t::SYS_EX, _serial.type());
+    EXPECT_EQ(6, _hwa._waits);
+}
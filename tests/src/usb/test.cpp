@@ -0,0 +1,401 @@
+#include "tests/common.h"
+#include "lib/midi/transport/usb/usb.h"
+#include "lib/midi/transport/usb/multiplexer.h"
+
+using namespace lib::midi;
+using namespace usb;
+
+namespace
+{
+    class UsbMidiTest : public ::testing::Test
+    {
+        protected:
+        void SetUp()
+        {
+            ASSERT_TRUE(_usb.init());
+        }
+
+        void TearDown()
+        {}
+
+        class UsbHwa : public Hwa
+        {
+            public:
+            UsbHwa() = default;
+
+            bool init() override
+            {
+                return true;
+            }
+
+            bool deInit() override
+            {
+                return true;
+            }
+
+            bool write(Packet& packet) override
+            {
+                _writePackets.push_back(packet.data);
+                return true;
+            }
+
+            bool read(Packet& packet) override
+            {
+                if (_readPackets.size())
+                {
+                    packet.data = _readPackets.at(0);
+                    _readPackets.erase(_readPackets.begin());
+
+                    return true;
+                }
+
+                return false;
+            }
+
+            bool write(const Packet* packets, size_t count) override
+            {
+                _writeCalls++;
+                return Hwa::write(packets, count);
+            }
+
+            size_t read(Packet* packets, size_t count) override
+            {
+                _readCalls++;
+                return Hwa::read(packets, count);
+            }
+
+            std::vector<std::array<uint8_t, 4>> _writePackets = {};
+            std::vector<std::array<uint8_t, 4>> _readPackets  = {};
+            size_t                              _writeCalls   = 0;
+            size_t                              _readCalls    = 0;
+        };
+
+        UsbHwa _hwa;
+        Usb    _usb = Usb(_hwa);
+    };
+}    // namespace
+
+TEST_F(UsbMidiTest, SendSysExSegments)
+{
+    const uint8_t HEADER[]   = { 0x00, 0x53, 0x43 };
+    const uint8_t PAYLOAD[]  = { 0x01, 0x02, 0x03, 0x04 };
+    const uint8_t CHECKSUM[] = { 0x05 };
+
+    const Segment SEGMENTS[] = {
+        { HEADER, sizeof(HEADER) },
+        { PAYLOAD, sizeof(PAYLOAD) },
+        { CHECKSUM, sizeof(CHECKSUM) },
+    };
+
+    const std::vector<std::array<uint8_t, 4>> EXPECTED = {
+        { 0x04, 0xF0, 0x00, 0x53 },
+        { 0x04, 0x43, 0x01, 0x02 },
+        { 0x04, 0x03, 0x04, 0x05 },
+        { 0x05, 0xF7, 0x00, 0x00 },
+    };
+
+    ASSERT_TRUE(_usb.sendSysEx(SEGMENTS, 3, false));
+    EXPECT_EQ(EXPECTED, _hwa._writePackets);
+
+    // same message in a single buffer with boundaries
+    const uint8_t SYS_EX[] = { 0xF0, 0x00, 0x53, 0x43, 0x01, 0x02, 0x03, 0x04, 0x05, 0xF7 };
+
+    _hwa._writePackets.clear();
+    ASSERT_TRUE(_usb.sendSysEx(sizeof(SYS_EX), SYS_EX, true));
+    EXPECT_EQ(EXPECTED, _hwa._writePackets);
+}
+
+TEST_F(UsbMidiTest, ReadBlock)
+{
+    _hwa._readPackets.push_back({ 0x09, 0x90, 0x3C, 0x7F });
+    _hwa._readPackets.push_back({ 0x0C, 0xC1, 0x05, 0x00 });
+    _hwa._readPackets.push_back({ 0x0F, 0xF8, 0x00, 0x00 });
+
+    const std::vector<uint8_t> EXPECTED = { 0x90, 0x3C, 0x7F, 0xC1, 0x05, 0xF8 };
+    std::vector<uint8_t>       data(16);
+
+    // packet is split between two reads
+    ASSERT_EQ(4, _usb.transport().read(data.data(), 4));
+    ASSERT_EQ(2, _usb.transport().read(&data.at(4), 12));
+    data.resize(6);
+    EXPECT_EQ(EXPECTED, data);
+}
+
+TEST_F(UsbMidiTest, ReadMessages)
+{
+    _hwa._readPackets.push_back({ 0x09, 0x91, 0x3C, 0x7F });    // note on, channel 2
+    _hwa._readPackets.push_back({ 0x04, 0xF0, 0x01, 0x02 });    // sysex, passed through parser
+    _hwa._readPackets.push_back({ 0x0F, 0xF8, 0x00, 0x00 });    // clock inside sysex
+    _hwa._readPackets.push_back({ 0x07, 0x03, 0x04, 0xF7 });
+    _hwa._readPackets.push_back({ 0x03, 0xF2, 0x10, 0x20 });    // song position
+    _hwa._readPackets.push_back({ 0x09, 0x80, 0x3C, 0x00 });    // CIN doesn't match status, passed through parser
+    _hwa._readPackets.push_back({ 0x0C, 0xC0, 0x05, 0x00 });    // program change
+
+    struct Expected
+    {
+        messageType_t type;
+        uint8_t       channel;
+        uint8_t       data1;
+        uint8_t       data2;
+        uint16_t      length;
+    };
+
+    const std::vector<Expected> EXPECTED = {
+        { messageType_t::NOTE_ON, 2, 0x3C, 0x7F, 3 },
+        { messageType_t::SYS_REAL_TIME_CLOCK, 0, 0, 0, 1 },
+        { messageType_t::SYS_EX, 0, 0, 0, 6 },
+        { messageType_t::SYS_COMMON_SONG_POSITION, 0, 0x10, 0x20, 3 },
+        { messageType_t::NOTE_OFF, 1, 0x3C, 0x00, 3 },
+        { messageType_t::PROGRAM_CHANGE, 1, 0x05, 0x00, 2 },
+    };
+
+    for (const auto& expected : EXPECTED)
+    {
+        ASSERT_TRUE(_usb.read());
+        EXPECT_EQ(expected.type, _usb.type());
+        EXPECT_EQ(expected.channel, _usb.channel());
+        EXPECT_EQ(expected.data1, _usb.data1());
+        EXPECT_EQ(expected.data2, _usb.data2());
+        EXPECT_EQ(expected.length, _usb.length());
+    }
+
+    const std::vector<uint8_t> SYS_EX = { 0xF0, 0x01, 0x02, 0x03, 0x04, 0xF7 };
+    EXPECT_EQ(SYS_EX, std::vector<uint8_t>(_usb.sysExArray(), _usb.sysExArray() + SYS_EX.size()));
+    EXPECT_FALSE(_usb.read());
+}
+
+TEST_F(UsbMidiTest, BatchedTransfers)
+{
+    ASSERT_TRUE(_usb.sendNoteOn(60, 127, 1));
+    ASSERT_TRUE(_usb.sendNoteOn(61, 127, 1));
+    ASSERT_TRUE(_usb.sendNoteOn(62, 127, 1));
+
+    // packets are kept until the buffer is full or until flushed
+    EXPECT_EQ(0, _hwa._writePackets.size());
+    ASSERT_TRUE(_usb.flush());
+    EXPECT_EQ(3, _hwa._writePackets.size());
+    EXPECT_EQ(1, _hwa._writeCalls);
+
+    for (size_t i = 0; i < MIDI_USB_TX_PACKETS; i++)
+    {
+        ASSERT_TRUE(_usb.sendNoteOff(60, 0, 1));
+    }
+
+    EXPECT_EQ(3 + MIDI_USB_TX_PACKETS, _hwa._writePackets.size());
+    EXPECT_EQ(2, _hwa._writeCalls);
+
+    // received transfer is retrieved at once
+    for (size_t i = 0; i < 8; i++)
+    {
+        _hwa._readPackets.push_back({ 0x09, 0x90, static_cast<uint8_t>(i), 0x7F });
+    }
+
+    for (size_t i = 0; i < 8; i++)
+    {
+        ASSERT_TRUE(_usb.read());
+        EXPECT_EQ(i, _usb.data1());
+    }
+
+    EXPECT_FALSE(_usb.read());
+    EXPECT_EQ(2, _hwa._readCalls);
+}
+
+TEST_F(UsbMidiTest, Multiplexer)
+{
+    Multiplexer multiplexer(_hwa);
+    Usb         port1(multiplexer.cable(0), 0);
+    Usb         port2(multiplexer.cable(3), 3);
+
+    ASSERT_TRUE(port1.init());
+    ASSERT_TRUE(port2.init());
+
+    _hwa._readPackets.push_back({ 0x39, 0x90, 0x3C, 0x7F });    // cable 3
+    _hwa._readPackets.push_back({ 0x09, 0x91, 0x3D, 0x7F });    // cable 0
+    _hwa._readPackets.push_back({ 0x1B, 0xB0, 0x07, 0x64 });    // cable 1, not read
+    _hwa._readPackets.push_back({ 0x3B, 0xB2, 0x07, 0x64 });    // cable 3
+
+    ASSERT_TRUE(port1.read());
+    EXPECT_EQ(messageType_t::NOTE_ON, port1.type());
+    EXPECT_EQ(2, port1.channel());
+
+    // entire transfer is read at once and routed to the cables
+    EXPECT_EQ(1, _hwa._readCalls);
+    EXPECT_EQ(0, _hwa._readPackets.size());
+    EXPECT_FALSE(port1.read());
+
+    ASSERT_TRUE(port2.read());
+    EXPECT_EQ(messageType_t::NOTE_ON, port2.type());
+    EXPECT_EQ(1, port2.channel());
+    ASSERT_TRUE(port2.read());
+    EXPECT_EQ(messageType_t::CONTROL_CHANGE, port2.type());
+    EXPECT_FALSE(port2.read());
+
+    // full buffers of both cables are collected and written at once
+    const size_t WRITE_CALLS = _hwa._writeCalls;
+
+    std::vector<std::array<uint8_t, 4>> expected;
+
+    for (uint8_t i = 0; i < MIDI_USB_TX_PACKETS; i++)
+    {
+        ASSERT_TRUE(port1.sendNoteOn(i, 127, 1));
+        expected.push_back({ 0x09, 0x90, i, 0x7F });
+    }
+
+    for (uint8_t i = 0; i < MIDI_USB_TX_PACKETS; i++)
+    {
+        ASSERT_TRUE(port2.sendNoteOn(i, 127, 1));
+        expected.push_back({ 0x39, 0x90, i, 0x7F });
+    }
+
+    EXPECT_EQ(0, _hwa._writePackets.size());
+
+    ASSERT_TRUE(multiplexer.flush());
+    EXPECT_EQ(WRITE_CALLS + 1, _hwa._writeCalls);
+    EXPECT_EQ(expected, _hwa._writePackets);
+}
+
+TEST_F(UsbMidiTest, MultiplexerFlush)
+{
+    Multiplexer multiplexer(_hwa);
+    Usb         port1(multiplexer.cable(0), 0);
+    Usb         port2(multiplexer.cable(3), 3);
+
+    ASSERT_TRUE(port1.init());
+    ASSERT_TRUE(port2.init());
+
+    // flushing any of the cables writes out everything collected by the multiplexer
+    ASSERT_TRUE(port1.sendNoteOn(60, 127, 1));
+    ASSERT_TRUE(port2.sendNoteOn(61, 127, 1));
+    ASSERT_TRUE(port2.flush());
+    EXPECT_EQ(1, _hwa._writePackets.size());
+
+    ASSERT_TRUE(port1.flush());
+
+    const std::vector<std::array<uint8_t, 4>> EXPECTED = {
+        { 0x39, 0x90, 0x3D, 0x7F },
+        { 0x09, 0x90, 0x3C, 0x7F },
+    };
+
+    EXPECT_EQ(EXPECTED, _hwa._writePackets);
+}
+
+TEST_F(UsbMidiTest, MultiplexerUnreadCable)
+{
+    Multiplexer multiplexer(_hwa);
+    Usb         port1(multiplexer.cable(0), 0);
+    Usb         port2(multiplexer.cable(3), 3);
+
+    ASSERT_TRUE(port1.init());
+    ASSERT_TRUE(port2.init());
+
+    // cable 9 isn't initialized, so its packets are dropped
+    for (size_t i = 0; i < (MIDI_USB_RX_PACKETS * 2); i++)
+    {
+        _hwa._readPackets.push_back({ 0x39, 0x90, static_cast<uint8_t>(i), 0x7F });
+        _hwa._readPackets.push_back({ 0x99, 0x90, 0x3C, 0x7F });
+        _hwa._readPackets.push_back({ 0x09, 0x90, static_cast<uint8_t>(i), 0x7F });
+    }
+
+    // cable 3 isn't read: once its queue is full, endpoint isn't read anymore instead of dropping data
+    size_t received = 0;
+
+    while (port1.read())
+    {
+        EXPECT_EQ(received++, port1.data1());
+    }
+
+    EXPECT_EQ(MIDI_USB_RX_PACKETS, received);
+    EXPECT_NE(0, _hwa._readPackets.size());
+
+    // once cable 3 is read, the held back packets are routed again
+    for (size_t i = 0; i < (MIDI_USB_RX_PACKETS * 2); i++)
+    {
+        ASSERT_TRUE(port2.read());
+        EXPECT_EQ(i, port2.data1());
+    }
+
+    while (port1.read())
+    {
+        EXPECT_EQ(received++, port1.data1());
+    }
+
+    EXPECT_EQ((MIDI_USB_RX_PACKETS * 2), received);
+    EXPECT_EQ(0, _hwa._readPackets.size());
+    EXPECT_EQ((MIDI_USB_RX_PACKETS * 2), multiplexer.dropped());
+}
+
+TEST_F(UsbMidiTest, MultiplexerBurst)
+{
+    Multiplexer multiplexer(_hwa);
+    Usb         port1(multiplexer.cable(0), 0);
+    Usb         port2(multiplexer.cable(3), 3);
+
+    ASSERT_TRUE(port1.init());
+    ASSERT_TRUE(port2.init());
+
+    // SysEx dump on cable 3 together with CC burst on cable 0, both much longer than cable queues
+    const size_t SYS_EX_PACKETS = MIDI_USB_RX_PACKETS * 2;
+
+    _hwa._readPackets.push_back({ 0x34, 0xF0, 0x00, 0x00 });
+
+    for (size_t i = 1; i < (SYS_EX_PACKETS - 1); i++)
+    {
+        const auto DATA = static_cast<uint8_t>(i & 0x7F);
+
+        _hwa._readPackets.push_back({ 0x34, DATA, DATA, DATA });
+        _hwa._readPackets.push_back({ 0x0B, 0xB0, 0x07, DATA });
+    }
+
+    _hwa._readPackets.push_back({ 0x37, 0x01, 0x02, 0xF7 });
+
+    // cables are read in turn, each one until it has no more data
+    size_t controlChanges = 0;
+    size_t sysExMessages  = 0;
+
+    for (size_t pass = 0; pass < SYS_EX_PACKETS; pass++)
+    {
+        while (port1.read())
+        {
+            EXPECT_EQ(messageType_t::CONTROL_CHANGE, port1.type());
+            EXPECT_EQ((controlChanges++ + 1) & 0x7F, port1.data2());
+        }
+
+        while (port2.read())
+        {
+            EXPECT_EQ(messageType_t::SYS_EX, port2.type());
+            EXPECT_EQ(SYS_EX_PACKETS * 3, port2.length());
+            sysExMessages++;
+        }
+    }
+
+    EXPECT_EQ(SYS_EX_PACKETS - 2, controlChanges);
+    EXPECT_EQ(1, sysExMessages);
+    EXPECT_EQ(0, multiplexer.dropped());
+}
+
+TEST_F(UsbMidiTest, RealTimeWithinSysEx)
+{
+    const std::vector<uint8_t> SYS_EX = { 0xF0, 0x01, 0x02, 0x03, 0x04, 0xF7 };
+
+    _usb.setSysExChunkSize(2);
+    ASSERT_TRUE(_usb.injectRealTime(messageType_t::SYS_REAL_TIME_CLOCK));
+    ASSERT_TRUE(_usb.sendSysEx(SYS_EX.size(), SYS_EX.data(), true));
+    ASSERT_TRUE(_usb.flush());
+
+    // clock is sent as soon as it's written, before incomplete SysEx packet
+    const std::vector<std::array<uint8_t, 4>> EXPECTED = {
+        { 0x0F, 0xF8, 0x00, 0x00 },
+        { 0x04, 0xF0, 0x01, 0x02 },
+        { 0x07, 0x03, 0x04, 0xF7 },
+    };
+
+    EXPECT_EQ(EXPECTED, _hwa._writePackets);
+
+    _hwa._readPackets = _hwa._writePackets;
+
+    ASSERT_TRUE(_usb.read());
+    EXPECT_EQ(messageType_t::SYS_REAL_TIME_CLOCK, _usb.type());
+    ASSERT_TRUE(_usb.read());
+    EXPECT_EQ(messageType_t::SYS_EX, _usb.type());
+    EXPECT_EQ(SYS_EX.size(), _usb.length());
+}